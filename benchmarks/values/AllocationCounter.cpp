@@ -0,0 +1,59 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<quint64> allocationsCount(0);
+
+void* allocate(std::size_t size)
+{
+    allocationsCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (size == 0)
+        size = 1;
+
+    if (auto p = std::malloc(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+} // end anonymous namespace
+
+quint64 AllocationCounter::allocations()
+{
+    return allocationsCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,13 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <QtGlobal>
+
+// counts calls of global operator new in the benchmarks process
+class AllocationCounter
+{
+public:
+    static quint64 allocations();
+};
+
+#endif // ALLOCATION_COUNTER_H
@@ -0,0 +1,390 @@
+#include "BenchAsyncValue.h"
+#include <QtTest/QtTest>
+#include <QtConcurrent>
+#include <atomic>
+#include <future>
+#include "values/AsyncValue.h"
+#include "values/AsyncValueRunThreadPool.h"
+#include "values/AsyncValueRunInline.h"
+#include "values/AsyncValueRunable.h"
+#include "values/AsyncMemoryResource.h"
+#include "values/AsyncReclaimer.h"
+#include "AllocationCounter.h"
+
+namespace
+{
+
+// reports average number of heap allocations per run
+template <typename Run>
+void benchmarkAllocations(Run run)
+{
+    // warm up thread pool and memory pools
+    for (int i = 0; i < 100; ++i)
+        run();
+
+    const int runs = 1000;
+    const auto before = AllocationCounter::allocations();
+    for (int i = 0; i < runs; ++i)
+        run();
+    const auto after = AllocationCounter::allocations();
+
+    QTest::setBenchmarkResult(qreal(after - before) / runs, QTest::Events);
+}
+
+template <typename NotifyPolicy>
+void benchmarkNotify(bool connected)
+{
+    using AsyncInt = AsyncValueTemplate<int, AsyncError, AsyncProgress, AsyncTrackErrorsPolicyDefault, AsyncTracePolicyDefault, NotifyPolicy>;
+    AsyncInt value(AsyncInitByValue(), 0);
+
+    int notifications = 0;
+    if (connected)
+        QObject::connect(&value, &AsyncValueBase::stateChanged, [&notifications]() { ++notifications; });
+
+    int i = 0;
+    QBENCHMARK {
+        value.emplaceError("error");
+        value.emplaceValue(++i);
+    }
+}
+
+} // end anonymous namespace
+
+void BenchAsyncValue::emplaceValue()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+
+    int i = 0;
+    QBENCHMARK {
+        value.emplaceValue(++i);
+    }
+}
+
+void BenchAsyncValue::moveValue()
+{
+    AsyncValue<QString> value(AsyncInitByValue(), "");
+
+    QBENCHMARK {
+        value.moveValue(std::make_unique<QString>("value"));
+    }
+}
+
+void BenchAsyncValue::notify_data()
+{
+    QTest::addColumn<QString>("policy");
+
+    for (auto policy : {"signal", "signal connected", "callbacks", "none"})
+        QTest::newRow(policy) << QString(policy);
+}
+
+void BenchAsyncValue::notify()
+{
+    QFETCH(QString, policy);
+
+    // state transitions with different notification policies
+    if (policy == "signal")
+        benchmarkNotify<AsyncNotifyPolicySignal>(false);
+    else if (policy == "signal connected")
+        benchmarkNotify<AsyncNotifyPolicySignal>(true);
+    else if (policy == "callbacks")
+        benchmarkNotify<AsyncNotifyPolicyCallbacks>(false);
+    else
+        benchmarkNotify<AsyncNotifyPolicyNone>(false);
+}
+
+void BenchAsyncValue::replaceBigValue_data()
+{
+    QTest::addColumn<bool>("reclaim");
+
+    QTest::newRow("destroy in place") << false;
+    QTest::newRow("reclaimer") << true;
+}
+
+void BenchAsyncValue::replaceBigValue()
+{
+    QFETCH(bool, reclaim);
+
+    AsyncReclaimer reclaimer;
+    AsyncValue<std::vector<QString>> value(AsyncInitByValue());
+    if (reclaim)
+        value.setReclaimer(&reclaimer);
+
+    // measures publish latency only, new values are prepared beforehand
+    std::vector<AsyncUniquePtr<std::vector<QString>>> values;
+    for (int i = 0; i < 100; ++i)
+        values.push_back(asyncMakeUnique<std::vector<QString>>(nullptr, 10000, QString("value")));
+
+    QBENCHMARK_ONCE {
+        for (auto& newValue : values)
+            value.moveValue(std::move(newValue));
+    }
+
+    reclaimer.flush();
+}
+
+void BenchAsyncValue::access_data()
+{
+    QTest::addColumn<int>("readers");
+
+    for (auto readers : {1, 2, 4, 8, 16, 32, 64})
+        QTest::newRow(QByteArray::number(readers)) << readers;
+}
+
+void BenchAsyncValue::access()
+{
+    QFETCH(int, readers);
+
+    AsyncValue<int> value(AsyncInitByValue(), 42);
+
+    // background readers compete with the measured one
+    std::atomic<bool> stop(false);
+    QThreadPool pool;
+    pool.setMaxThreadCount(readers);
+    for (int i = 1; i < readers; ++i)
+    {
+        QtConcurrent::run(&pool, [&value, &stop]() {
+            int sum = 0;
+            while (!stop.load(std::memory_order_relaxed))
+                value.accessValue([&sum](int val) { sum += val; });
+        });
+    }
+
+    int sum = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i)
+            value.accessValue([&sum](int val) { sum += val; });
+    }
+
+    stop = true;
+    pool.waitForDone();
+
+    QVERIFY(sum > 0);
+}
+
+void BenchAsyncValue::poll_data()
+{
+    QTest::addColumn<bool>("ifChanged");
+
+    QTest::newRow("access") << false;
+    QTest::newRow("accessIfChangedSince") << true;
+}
+
+void BenchAsyncValue::poll()
+{
+    QFETCH(bool, ifChanged);
+
+    // refresh loop over many values where only a few change between passes
+    std::vector<std::unique_ptr<AsyncValue<int>>> values;
+    for (int i = 0; i < 10000; ++i)
+        values.push_back(std::make_unique<AsyncValue<int>>(AsyncInitByValue(), i));
+    std::vector<quint64> versions(values.size(), 0);
+
+    int sum = 0;
+    auto onValue = [&sum](int val) { sum += val; };
+    auto onOther = [&sum](const auto&) { sum -= 1; };
+
+    int pass = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 10; ++i)
+            values[(pass * 10 + i) % values.size()]->emplaceValue(pass);
+        ++pass;
+
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (ifChanged)
+                values[i]->accessIfChangedSince(versions[i], onValue, onOther, onOther);
+            else
+                values[i]->access(onValue, onOther, onOther);
+        }
+    }
+
+    QVERIFY(sum != 0);
+}
+
+void BenchAsyncValue::wait_data()
+{
+    QTest::addColumn<int>("waiters");
+
+    for (auto waiters : {1, 16, 256, 1024, 10000})
+        QTest::newRow(QByteArray::number(waiters)) << waiters;
+}
+
+void BenchAsyncValue::wait()
+{
+    QFETCH(int, waiters);
+
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(waiters);
+    // waiters need little stack, keep address space of thousands threads small
+    pool.setStackSize(256 * 1024);
+
+    // measures time to wake up all waiters
+    QBENCHMARK {
+        auto progress = std::make_unique<AsyncProgress>("", ASYNC_CAN_REQUEST_STOP::NO);
+        auto progressPtr = progress.get();
+        QVERIFY(value.startProgress(std::move(progress)));
+
+        std::vector<QFuture<void>> clients;
+        for (int i = 0; i < waiters; ++i)
+        {
+            clients.push_back(QtConcurrent::run(&pool, [&value]() {
+                value.wait();
+            }));
+        }
+
+        // complete only when every waiter sleeps, otherwise fast path waiters are measured
+        while (value.waitersCount() != waiters)
+            QThread::yieldCurrentThread();
+
+        value.emplaceValue(42);
+        value.completeProgress(progressPtr);
+
+        for (auto& client : clients)
+            client.waitForFinished();
+    }
+}
+
+void BenchAsyncValue::progressRoundTrip()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+
+    QBENCHMARK {
+        auto progress = std::make_unique<AsyncProgress>("", ASYNC_CAN_REQUEST_STOP::NO);
+        auto progressPtr = progress.get();
+        value.startProgress(std::move(progress));
+        value.emplaceValue(42);
+        value.completeProgress(progressPtr);
+    }
+}
+
+void BenchAsyncValue::rerunStorm()
+{
+    using AsyncInt = AsyncValueRunableFn<int>;
+    AsyncInt value(AsyncInitByValue(), 0);
+
+    std::atomic<int> runs(0);
+    value.deferFn = [&value](const AsyncInt::RunFnType& fn) {
+        asyncValueRunThreadPool(value, fn, "", ASYNC_CAN_REQUEST_STOP::YES);
+    };
+    value.runFn = [&runs](AsyncProgressRerun&, AsyncInt& value) {
+        value.emplaceValue(++runs);
+    };
+
+    QBENCHMARK {
+        for (int i = 0; i < 100; ++i)
+            value.run();
+
+        value.wait();
+    }
+
+    QVERIFY(runs > 0);
+}
+
+void BenchAsyncValue::runThreadPool()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+
+    QBENCHMARK {
+        asyncValueRunThreadPool(value, [](AsyncProgress&, AsyncValue<int>& value) {
+            value.emplaceValue(42);
+        }, "", ASYNC_CAN_REQUEST_STOP::NO);
+
+        value.wait();
+    }
+}
+
+void BenchAsyncValue::runThreadPoolAllocations()
+{
+    // allocate value content from pools too
+    AsyncMemoryResourceScope scope(AsyncMemoryResource::threadPools());
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+
+    benchmarkAllocations([&value]() {
+        asyncValueRunThreadPool(value, [](AsyncProgress&, AsyncValue<int>& value) {
+            value.emplaceValue(42);
+        }, QString(), ASYNC_CAN_REQUEST_STOP::NO);
+
+        value.wait();
+    });
+}
+
+void BenchAsyncValue::runInline()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+
+    QBENCHMARK {
+        asyncValueRunInline(value, [](AsyncProgress&, AsyncValue<int>& value) {
+            value.emplaceValue(42);
+        }, "", ASYNC_CAN_REQUEST_STOP::NO);
+
+        value.wait();
+    }
+}
+
+void BenchAsyncValue::runAdaptive()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+
+    // the first run is measured in thread pool, next ones go inline
+    QBENCHMARK {
+        asyncValueRunAdaptive(value, [](AsyncProgress&, AsyncValue<int>& value) {
+            value.emplaceValue(42);
+        }, "", ASYNC_CAN_REQUEST_STOP::NO);
+
+        value.wait();
+    }
+}
+
+void BenchAsyncValue::runQFuture()
+{
+    QBENCHMARK {
+        auto future = QtConcurrent::run([]() {
+            return 42;
+        });
+
+        future.waitForFinished();
+    }
+}
+
+void BenchAsyncValue::runQFutureAllocations()
+{
+    benchmarkAllocations([]() {
+        auto future = QtConcurrent::run([]() {
+            return 42;
+        });
+
+        future.waitForFinished();
+    });
+}
+
+void BenchAsyncValue::runStdFuture()
+{
+    QBENCHMARK {
+        auto future = std::async(std::launch::async, []() {
+            return 42;
+        });
+
+        future.wait();
+    }
+}
+
+void BenchAsyncValue::publishAsyncValue()
+{
+    QBENCHMARK {
+        AsyncValue<int> value(AsyncInitByError(), "");
+        value.emplaceValue(42);
+        value.accessValue(AsyncNoOp());
+    }
+}
+
+void BenchAsyncValue::publishStdPromise()
+{
+    QBENCHMARK {
+        std::promise<int> promise;
+        auto future = promise.get_future();
+        promise.set_value(42);
+        future.get();
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef BENCH_ASYNC_VALUE_H
+#define BENCH_ASYNC_VALUE_H
+
+#include <QObject>
+
+class BenchAsyncValue: public QObject
+{
+    Q_OBJECT
+
+public:
+    Q_INVOKABLE BenchAsyncValue() {}
+
+private Q_SLOTS:
+
+    void emplaceValue();
+    void moveValue();
+    void notify_data();
+    void notify();
+    void replaceBigValue_data();
+    void replaceBigValue();
+    void access_data();
+    void access();
+    void poll_data();
+    void poll();
+    void wait_data();
+    void wait();
+    void progressRoundTrip();
+    void rerunStorm();
+    void runThreadPoolAllocations();
+    void runInline();
+    void runAdaptive();
+
+    // baselines
+    void runThreadPool();
+    void runQFuture();
+    void runQFutureAllocations();
+    void runStdFuture();
+    void publishAsyncValue();
+    void publishStdPromise();
+};
+
+#endif // BENCH_ASYNC_VALUE_H
@@ -0,0 +1,28 @@
+#include "BenchAsyncValue.h"
+#include <QtTest/QtTest>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int result = 0;
+
+    QList<const QMetaObject *> benchmarks;
+
+    // register benchmarks
+    benchmarks.append(&BenchAsyncValue::staticMetaObject);
+
+    // run benchmarks
+    foreach (const QMetaObject *benchmarkMetaObject, benchmarks)
+    {
+        QScopedPointer<QObject> benchmark(benchmarkMetaObject->newInstance());
+        Q_ASSERT(benchmark);
+
+        if (benchmark)
+        {
+            result |= QTest::qExec(benchmark.data(), argc, argv);
+        }
+    }
+
+    return result;
+}
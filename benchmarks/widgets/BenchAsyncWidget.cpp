@@ -0,0 +1,356 @@
+#include "BenchAsyncWidget.h"
+#include "values/AsyncValue.h"
+#include "values/AsyncValueRunThreadPool.h"
+#include "widgets/AsyncWidget.h"
+#include "widgets/AsyncWidgetPrepared.h"
+#include <QApplication>
+#include <QEvent>
+#include <QFile>
+#include <QGridLayout>
+#include <QImage>
+#include <QLabel>
+#include <QPainter>
+#include <QTextStream>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+struct WidgetCounters
+{
+    qint64 value = 0;
+    qint64 error = 0;
+    qint64 progress = 0;
+    qint64 prepared = 0;
+};
+
+WidgetCounters widgetCounters;
+
+using AsyncInt = AsyncValue<int>;
+using AsyncImage = AsyncValue<QImage>;
+
+class CountingWidgetFn : public AsyncWidgetFn<AsyncInt>
+{
+public:
+    using AsyncWidgetFn<AsyncInt>::AsyncWidgetFn;
+
+protected:
+    QWidget* createValueWidgetImpl(int& value, QWidget* parent) override
+    {
+        ++widgetCounters.value;
+        return AsyncWidgetFn<AsyncInt>::createValueWidgetImpl(value, parent);
+    }
+
+    QWidget* createErrorWidgetImpl(AsyncError& error, QWidget* parent) override
+    {
+        ++widgetCounters.error;
+        return AsyncWidgetFn<AsyncInt>::createErrorWidgetImpl(error, parent);
+    }
+
+    QWidget* createProgressWidgetImpl(AsyncProgress& progress, QWidget* parent) override
+    {
+        ++widgetCounters.progress;
+        return AsyncWidgetFn<AsyncInt>::createProgressWidgetImpl(progress, parent);
+    }
+};
+
+// the same way as MyPixmapWidget in demo application
+class CountingWidgetPrepared : public AsyncWidgetPrepared<AsyncImage, QImage>
+{
+public:
+    using AsyncWidgetPrepared<AsyncImage, QImage>::AsyncWidgetPrepared;
+
+protected:
+    QWidget* createPreparedWidgetImpl(QImage& image, QWidget* parent) override
+    {
+        ++widgetCounters.prepared;
+        auto label = new QLabel(parent);
+        label->setAlignment(Qt::AlignCenter);
+        label->setPixmap(QPixmap::fromImage(std::move(image)));
+        return label;
+    }
+
+    QWidget* createValueWidgetImpl(QImage& value, QWidget* parent) override
+    {
+        ++widgetCounters.value;
+        return AsyncWidgetPrepared<AsyncImage, QImage>::createValueWidgetImpl(value, parent);
+    }
+
+    QWidget* createErrorWidgetImpl(AsyncError& error, QWidget* parent) override
+    {
+        ++widgetCounters.error;
+        return AsyncWidgetPrepared<AsyncImage, QImage>::createErrorWidgetImpl(error, parent);
+    }
+
+    QWidget* createProgressWidgetImpl(AsyncProgress& progress, QWidget* parent) override
+    {
+        ++widgetCounters.progress;
+        return AsyncWidgetPrepared<AsyncImage, QImage>::createProgressWidgetImpl(progress, parent);
+    }
+};
+
+QImage generateImage(int seed)
+{
+    QImage image(256, 256, QImage::Format_ARGB32_Premultiplied);
+    image.fill(QColor::fromHsv(seed % 360, 128, 255));
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.drawEllipse(image.rect().adjusted(16, 16, -16, -16));
+    painter.drawText(image.rect(), Qt::AlignCenter, QString::number(seed));
+
+    return image;
+}
+
+template <typename AsyncValueType, typename CreateValue>
+bool startRun(AsyncValueType& value, int workMs, bool error, CreateValue createValue)
+{
+    // value is still calculating, skip it
+    if (value.accessProgress([](AsyncProgress&) {}))
+        return false;
+
+    return asyncValueRunThreadPool(value, [workMs, error, createValue](AsyncProgress& progress, AsyncValueType& value) {
+        const int steps = 4;
+        for (int step = 0; step < steps; ++step)
+        {
+            progress.setProgress(step, steps);
+            QThread::msleep(static_cast<unsigned long>(workMs / steps));
+        }
+
+        if (error)
+            value.emplaceError("Simulated error");
+        else
+            value.emplaceValue(createValue());
+    }, "Calculating...", ASYNC_CAN_REQUEST_STOP::NO);
+}
+
+qint64 residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+
+    auto fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+qint64 percentile(QVector<qint64> samples, double p)
+{
+    if (samples.isEmpty())
+        return 0;
+
+    auto index = std::min(samples.size() - 1, static_cast<int>(p * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+QString formatMs(qint64 ns)
+{
+    return QString::number(ns / 1e6, 'f', 2) + "ms";
+}
+
+} // end anonymous namespace
+
+BenchAsyncWidget::BenchAsyncWidget(const BenchAsyncWidgetOptions& options)
+    : m_options(options),
+      m_random(options.seed)
+{
+    m_window = std::make_unique<QWidget>();
+    m_window->setWindowTitle("qt-async widget benchmark");
+    m_window->installEventFilter(this);
+
+    if (m_options.mode == "prepared")
+        createPreparedWidgets(m_window.get());
+    else
+        createFnWidgets(m_window.get());
+
+    // 1ms heartbeat detects event loop stalls
+    m_heartbeatTimer.setTimerType(Qt::PreciseTimer);
+    m_heartbeatTimer.setInterval(1);
+    connect(&m_heartbeatTimer, &QTimer::timeout, this, &BenchAsyncWidget::onHeartbeat);
+
+    m_driveTimer.setTimerType(Qt::PreciseTimer);
+    m_driveTimer.setInterval(std::max(1, 1000 / std::max(1, m_options.rate)));
+    connect(&m_driveTimer, &QTimer::timeout, this, &BenchAsyncWidget::onDrive);
+}
+
+BenchAsyncWidget::~BenchAsyncWidget()
+{
+    // widgets reference values, values shouldn't be in progress on destruction
+    QThreadPool::globalInstance()->waitForDone();
+    m_window.reset();
+    QThreadPool::globalInstance()->waitForDone();
+    m_values.clear();
+}
+
+void BenchAsyncWidget::createFnWidgets(QWidget* parent)
+{
+    auto layout = new QGridLayout(parent);
+    const int columns = static_cast<int>(std::ceil(std::sqrt(m_options.widgets)));
+
+    for (int i = 0; i < m_options.widgets; ++i)
+    {
+        auto value = std::make_shared<AsyncInt>(AsyncInitByValue(), i);
+        auto widget = new CountingWidgetFn(parent);
+        widget->createValueWidget = [](int& value, QWidget* parent) {
+            return AsyncWidgetProxy::createLabel(QString::number(value), parent);
+        };
+        widget->setValue(value.get());
+        widget->setMinimumSize(80, 40);
+        layout->addWidget(widget, i / columns, i % columns);
+
+        auto valuePtr = value.get();
+        m_runs.push_back([this, valuePtr](bool error) {
+            auto next = static_cast<int>(m_random() % 1000);
+            return startRun(*valuePtr, m_options.workMs, error, [next]() { return next; });
+        });
+        m_values.push_back(std::move(value));
+    }
+}
+
+void BenchAsyncWidget::createPreparedWidgets(QWidget* parent)
+{
+    auto layout = new QGridLayout(parent);
+    const int columns = static_cast<int>(std::ceil(std::sqrt(m_options.widgets)));
+
+    for (int i = 0; i < m_options.widgets; ++i)
+    {
+        auto value = std::make_shared<AsyncImage>(AsyncInitByValue(), generateImage(i));
+        auto widget = new CountingWidgetPrepared(parent);
+        // scale image in a worker thread
+        widget->prepareValue = [](const QImage& value, QSize size) {
+            return value.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                    .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        };
+        widget->setValue(value.get());
+        widget->setMinimumSize(80, 80);
+        layout->addWidget(widget, i / columns, i % columns);
+
+        auto valuePtr = value.get();
+        m_runs.push_back([this, valuePtr](bool error) {
+            auto next = static_cast<int>(m_random() % 1000);
+            return startRun(*valuePtr, m_options.workMs, error, [next]() { return generateImage(next); });
+        });
+        m_values.push_back(std::move(value));
+    }
+}
+
+void BenchAsyncWidget::run()
+{
+    QTextStream out(stdout);
+
+    out << "mode: " << m_options.mode
+        << ", widgets: " << m_options.widgets
+        << ", rate: " << m_options.rate << "/s"
+        << ", work: " << m_options.workMs << "ms"
+        << ", seconds: " << m_options.seconds
+        << ", seed: " << m_options.seed
+        << ", platform: " << QGuiApplication::platformName() << '\n';
+    out.flush();
+
+    m_window->resize(1024, 768);
+    m_window->show();
+    QApplication::processEvents();
+
+    const auto memoryBefore = residentMemory();
+    widgetCounters = WidgetCounters();
+
+    m_clock.start();
+    m_heartbeatTimer.start();
+    m_driveTimer.start();
+
+    QTimer::singleShot(m_options.seconds * 1000, qApp, &QCoreApplication::quit);
+    qApp->exec();
+
+    m_driveTimer.stop();
+    m_heartbeatTimer.stop();
+
+    const auto elapsedNs = m_clock.nsecsElapsed();
+    const auto memoryAfter = residentMemory();
+
+    // time GUI thread didn't respond longer than a frame (16ms)
+    qint64 stallNs = 0;
+    qint64 maxHeartbeat = 0;
+    for (auto interval : m_heartbeatIntervals)
+    {
+        if (interval > 16000000)
+            stallNs += interval;
+        maxHeartbeat = std::max(maxHeartbeat, interval);
+    }
+
+    out << "runs started: " << m_runsStarted << ", skipped (in progress): " << m_runsSkipped << '\n';
+    out << "event loop: heartbeats " << m_heartbeatIntervals.size()
+        << ", p50 " << formatMs(percentile(m_heartbeatIntervals, 0.5))
+        << ", p99 " << formatMs(percentile(m_heartbeatIntervals, 0.99))
+        << ", max " << formatMs(maxHeartbeat)
+        << ", stalled " << formatMs(stallNs)
+        << " (" << QString::number(100. * stallNs / elapsedNs, 'f', 1) << "%)" << '\n';
+    out << "frames: " << m_frameIntervals.size() + 1
+        << ", p50 " << formatMs(percentile(m_frameIntervals, 0.5))
+        << ", p99 " << formatMs(percentile(m_frameIntervals, 0.99)) << '\n';
+    out << "widgets created: value " << widgetCounters.value
+        << ", error " << widgetCounters.error
+        << ", progress " << widgetCounters.progress
+        << ", prepared " << widgetCounters.prepared << '\n';
+
+    if (memoryBefore >= 0 && memoryAfter >= 0)
+    {
+        out << "resident memory: " << memoryBefore / 1024 << "KB -> " << memoryAfter / 1024 << "KB"
+            << " (" << (memoryAfter - memoryBefore) / 1024 << "KB)" << '\n';
+    }
+
+    out.flush();
+}
+
+bool BenchAsyncWidget::eventFilter(QObject* watched, QEvent* event)
+{
+    // every backing store flush of the window is a frame
+    if (watched == m_window.get() && event->type() == QEvent::UpdateRequest && m_clock.isValid())
+    {
+        auto now = m_clock.nsecsElapsed();
+        if (m_lastFrame >= 0)
+            m_frameIntervals.append(now - m_lastFrame);
+        m_lastFrame = now;
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void BenchAsyncWidget::onHeartbeat()
+{
+    auto now = m_clock.nsecsElapsed();
+    if (m_lastHeartbeat >= 0)
+        m_heartbeatIntervals.append(now - m_lastHeartbeat);
+    m_lastHeartbeat = now;
+}
+
+void BenchAsyncWidget::onDrive()
+{
+    // keep requested rate even if timer fires rarely
+    const auto expected = m_clock.nsecsElapsed() * m_options.rate / 1000000000;
+
+    while (m_runsStarted + m_runsSkipped < expected)
+    {
+        auto& run = m_runs[m_nextRun];
+        m_nextRun = (m_nextRun + 1) % m_runs.size();
+
+        // every 10th calculation fails
+        if (run(m_random() % 10 == 0))
+            ++m_runsStarted;
+        else
+            ++m_runsSkipped;
+    }
+}
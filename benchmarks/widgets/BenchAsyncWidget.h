@@ -0,0 +1,71 @@
+#ifndef BENCH_ASYNC_WIDGET_H
+#define BENCH_ASYNC_WIDGET_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include <random>
+
+class QWidget;
+
+struct BenchAsyncWidgetOptions
+{
+    // "fn" - AsyncWidgetFn with labels, "prepared" - AsyncWidgetPrepared with images
+    QString mode = "fn";
+    int widgets = 100;
+    // value state changes per second for all widgets
+    int rate = 200;
+    // calculation time of one value
+    int workMs = 20;
+    int seconds = 10;
+    quint32 seed = 0;
+};
+
+// drives async values shown by async widgets through state changes
+// and measures GUI thread responsiveness
+class BenchAsyncWidget : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BenchAsyncWidget(const BenchAsyncWidgetOptions& options);
+    ~BenchAsyncWidget() override;
+
+    // runs event loop for options.seconds and prints report
+    void run();
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    void createFnWidgets(QWidget* parent);
+    void createPreparedWidgets(QWidget* parent);
+
+    void onHeartbeat();
+    void onDrive();
+
+    BenchAsyncWidgetOptions m_options;
+    std::mt19937 m_random;
+
+    std::unique_ptr<QWidget> m_window;
+    std::vector<std::shared_ptr<void>> m_values;
+    std::vector<std::function<bool(bool error)>> m_runs;
+    size_t m_nextRun = 0;
+
+    QTimer m_heartbeatTimer;
+    QTimer m_driveTimer;
+    QElapsedTimer m_clock;
+
+    qint64 m_lastHeartbeat = -1;
+    QVector<qint64> m_heartbeatIntervals;
+    qint64 m_lastFrame = -1;
+    QVector<qint64> m_frameIntervals;
+
+    qint64 m_runsStarted = 0;
+    qint64 m_runsSkipped = 0;
+};
+
+#endif // BENCH_ASYNC_WIDGET_H
@@ -0,0 +1,47 @@
+#include "BenchAsyncWidget.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <random>
+
+int main(int argc, char *argv[])
+{
+    // run headless by default so benchmark works on CI machines without display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("qt-async-widget-benchmarks");
+
+    BenchAsyncWidgetOptions options;
+    options.seed = std::random_device()();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("GUI responsiveness benchmark of async widgets");
+    parser.addHelpOption();
+    QCommandLineOption modeOption("mode", "Widgets to benchmark: fn or prepared.", "mode", options.mode);
+    QCommandLineOption widgetsOption("widgets", "Number of async widgets.", "count", QString::number(options.widgets));
+    QCommandLineOption rateOption("rate", "Value state changes per second.", "rate", QString::number(options.rate));
+    QCommandLineOption workOption("work", "Calculation time of one value in ms.", "ms", QString::number(options.workMs));
+    QCommandLineOption secondsOption("seconds", "Benchmark duration.", "seconds", QString::number(options.seconds));
+    QCommandLineOption seedOption("seed", "Random seed.", "seed");
+    parser.addOption(modeOption);
+    parser.addOption(widgetsOption);
+    parser.addOption(rateOption);
+    parser.addOption(workOption);
+    parser.addOption(secondsOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+
+    options.mode = parser.value(modeOption);
+    options.widgets = qMax(1, parser.value(widgetsOption).toInt());
+    options.rate = qMax(1, parser.value(rateOption).toInt());
+    options.workMs = qMax(0, parser.value(workOption).toInt());
+    options.seconds = qMax(1, parser.value(secondsOption).toInt());
+    if (parser.isSet(seedOption))
+        options.seed = parser.value(seedOption).toUInt();
+
+    BenchAsyncWidget benchmark(options);
+    benchmark.run();
+
+    return 0;
+}
@@ -0,0 +1,30 @@
+QT += core widgets concurrent
+
+TARGET = qt-async-widget-benchmarks
+
+CONFIG   += console
+CONFIG   -= app_bundle
+CONFIG   += c++14
+
+TEMPLATE = app
+
+include(../../sanitizers.pri)
+
+HEADERS += \
+    BenchAsyncWidget.h
+
+SOURCES += main.cpp \
+    BenchAsyncWidget.cpp
+
+INCLUDEPATH += ../../qt-async-lib
+
+win32 {
+    CONFIG(debug, debug|release): ASYNC_LIB_PATH = $$OUT_PWD/../../qt-async-lib/debug
+    CONFIG(release, debug|release): ASYNC_LIB_PATH = $$OUT_PWD/../../qt-async-lib/release
+} else:unix {
+    ASYNC_LIB_PATH = $$OUT_PWD/../../qt-async-lib
+}
+
+LIBS += -L$$ASYNC_LIB_PATH -lqt-async-lib
+
+win32:PRE_TARGETDEPS += $$ASYNC_LIB_PATH/qt-async-lib.lib
@@ -6,6 +6,8 @@ QT += concurrent
 TARGET = qt-async-demo
 TEMPLATE = app
 
+include(../sanitizers.pri)
+
 SOURCES +=  main.cpp\
             MainWindow.cpp 
 
@@ -3,7 +3,7 @@
 
 #include "values/AsyncValueRunable.h"
 #include "values/AsyncValueRunThread.h"
-#include "widgets/AsyncWidget.h"
+#include "widgets/AsyncWidgetPrepared.h"
 #include <QBitmap>
 
 class MyPixmap : public AsyncValueRunableAbstract<QPixmap>
@@ -71,21 +71,32 @@ private:
     QString m_imageUrl;
 };
 
-class MyPixmapWidget : public AsyncWidget<MyPixmap>
+class MyPixmapWidget : public AsyncWidgetPrepared<MyPixmap, QImage, QImage>
 {
 public:
     MyPixmapWidget(QWidget* parent, MyPixmap* value)
-        : AsyncWidget<MyPixmap>(parent)
+        : AsyncWidgetPrepared<MyPixmap, QImage, QImage>(parent)
     {
+        // QPixmap can be used in GUI thread only
+        copyValue = [](QPixmap& value) {
+            return value.toImage();
+        };
+
+        // scale image in a worker thread
+        prepareValue = [](const QImage& image, QSize size) {
+            return image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                    .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        };
+
         setValue(value);
     }
 
 protected:
-    QWidget* createValueWidgetImpl(ValueType& value, QWidget* parent) final
+    QWidget* createPreparedWidgetImpl(QImage& image, QWidget* parent) final
     {
         auto label = new QLabel(parent);
         label->setAlignment(Qt::AlignCenter);
-        label->setPixmap(value);
+        label->setPixmap(QPixmap::fromImage(std::move(image)));
         label->setStyleSheet("border: 1px solid black");
         return label;
     }
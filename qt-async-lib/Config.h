@@ -19,4 +19,45 @@
 
 #define ASYNC_PROGRESS_WIDGET_UPDATE_TIMEOUT 200
 
+// default delay before progress widget is shown
+// previous content widget stays visible during the delay
+#define ASYNC_PROGRESS_WIDGET_SHOW_DELAY 0
+// default minimal time progress widget stays visible once shown
+#define ASYNC_PROGRESS_WIDGET_MIN_DURATION 0
+
+// how long async widget in "run on visible" mode may stay hidden before its value is stopped
+#define ASYNC_WIDGET_HIDDEN_STOP_TIMEOUT 5000
+
+// how often changed rows of async item models are reported to views
+#define ASYNC_ITEM_MODEL_UPDATE_TIMEOUT 50
+
+// maximal number of events AsyncTrace keeps in memory
+#define ASYNC_TRACE_MAX_EVENTS 1000000
+
+// default thresholds (ms) of AsyncWatchdog
+#define ASYNC_WATCHDOG_PROGRESS_THRESHOLD 30000
+#define ASYNC_WATCHDOG_WAIT_THRESHOLD 10000
+#define ASYNC_WATCHDOG_LOCK_HOLD_THRESHOLD 1000
+#define ASYNC_WATCHDOG_CHECK_INTERVAL 500
+
+// AsyncStripedLock has 2^ASYNC_STRIPED_LOCK_BITS stripes
+#define ASYNC_STRIPED_LOCK_BITS 8
+
+// asyncValueRunAdaptive runs calculations shorter than this (microseconds) in the calling thread
+#define ASYNC_INLINE_RUN_THRESHOLD 1000
+
+// AsyncReclaimer destroys smaller objects in the calling thread
+#define ASYNC_RECLAIMER_MIN_BYTES 4096
+// AsyncReclaimer destroys objects in the calling thread if more bytes wait for destruction
+#define ASYNC_RECLAIMER_MAX_PENDING_BYTES (256 * 1024 * 1024)
+
+// asyncValueRunFuture checks stop request of the progress every interval (milliseconds)
+#define ASYNC_FUTURE_STOP_POLL_INTERVAL 100
+
+// uncomment (or add to DEFINES) to collect lock contention statistics (see AsyncLockStats.h)
+// #define ASYNC_LOCK_STATS
+
+// uncomment (or add to DEFINES) to collect runtime metrics (see AsyncMetrics.h)
+// #define ASYNC_METRICS
+
 #endif // ASYNC_CONFIG_H
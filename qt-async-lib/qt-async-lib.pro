@@ -8,13 +8,28 @@ VERSION = 1.0.0
 QT       += widgets concurrent network
 QT       -= gui
 
+include(../sanitizers.pri)
+
 SOURCES += \
     values/AsyncValueBase.cpp \
+    values/AsyncTrace.cpp \
+    values/AsyncLockStats.cpp \
+    values/AsyncMetrics.cpp \
+    values/AsyncWatchdog.cpp \
+    values/AsyncMemoryResource.cpp \
+    values/AsyncStripedLock.cpp \
+    values/AsyncValueCompactBase.cpp \
+    values/AsyncValueCompactNotifier.cpp \
+    values/AsyncEviction.cpp \
+    values/AsyncDiskCache.cpp \
+    values/AsyncReclaimer.cpp \
     widgets/AsyncWidgetProxy.cpp \
     widgets/AsyncWidgetError.cpp \
     widgets/AsyncWidgetProgressBar.cpp \
     widgets/AsyncWidgetProgressSpinner.cpp \
     widgets/AsyncWidgetProgressCircle.cpp \
+    widgets/AsyncItemModelBase.cpp \
+    widgets/AsyncItemDelegate.cpp \
     third_party/QtWaitingSpinner/waitingspinnerwidget.cpp \
     third_party/QtProgressCircle/ProgressCircle.cpp
 
@@ -26,17 +41,42 @@ HEADERS += \
     values/AsyncProgress.h \
     values/AsyncValue.h \
     values/AsyncValueRunThreadPool.h \
+    values/AsyncValueRunInline.h \
     values/AsyncTrackErrorsPolicy.h \
+    values/AsyncTracePolicy.h \
+    values/AsyncNotifyPolicy.h \
+    values/AsyncTrace.h \
+    values/AsyncLockStats.h \
+    values/AsyncMetrics.h \
+    values/AsyncWatchdog.h \
+    values/AsyncMemoryResource.h \
+    values/AsyncRunnable.h \
+    values/AsyncStripedLock.h \
+    values/AsyncValueCompactBase.h \
+    values/AsyncValueCompactTemplate.h \
+    values/AsyncValueCompact.h \
+    values/AsyncValueCompactNotifier.h \
+    values/AsyncEviction.h \
+    values/AsyncValueEvictable.h \
+    values/AsyncDiskCache.h \
+    values/AsyncValuePersistent.h \
+    values/AsyncReclaimer.h \
     values/AsyncValueRunThread.h \
     values/AsyncValueRunable.h \
+    values/AsyncValueLazy.h \
     values/AsyncValueRunNetwork.h \
+    values/AsyncValueRunFuture.h \
     widgets/AsyncWidgetProxy.h \
     widgets/AsyncWidgetBase.h \
     widgets/AsyncWidget.h \
+    widgets/AsyncWidgetPrepared.h \
     widgets/AsyncWidgetError.h \
     widgets/AsyncWidgetProgressBar.h \
     widgets/AsyncWidgetProgressSpinner.h \
     widgets/AsyncWidgetProgressCircle.h \
+    widgets/AsyncItemModelBase.h \
+    widgets/AsyncItemModel.h \
+    widgets/AsyncItemDelegate.h \
     third_party/scope_exit.h \
     third_party/QtWaitingSpinner/waitingspinnerwidget.h \
     third_party/QtProgressCircle/ProgressCircle.h
@@ -8,6 +8,9 @@
 #include <QPainter>
 #include <QPixmapCache>
 
+// number of pre-rendered frames for infinite animation
+static const int infiniteAnimationFrames = 64;
+
 ProgressCircle::ProgressCircle(QWidget *parent) :
     QWidget(parent),
     mValue(0),
@@ -138,22 +141,36 @@ QRectF squared(QRectF rect)
 
 void ProgressCircle::paintEvent(QPaintEvent *)
 {
+    // frames are shared between all progress circles with the same look
+    const qreal dpr = devicePixelRatioF();
+    const QString pixmapKey = key(dpr);
+
     QPixmap pixmap;
-    if (!QPixmapCache::find(key(), pixmap))
+    if (!QPixmapCache::find(pixmapKey, &pixmap))
     {
-        pixmap = generatePixmap();
-        QPixmapCache::insert(key(), pixmap);
+        pixmap = generatePixmap(dpr);
+        QPixmapCache::insert(pixmapKey, pixmap);
     }
 
     // Draw pixmap at center of item
+    const QSizeF pixmapSize = QSizeF(pixmap.size()) / dpr;
     QPainter painter(this);
-    painter.drawPixmap( 0.5 * ( width() - pixmap.width() ), 0.5 * ( height() - pixmap.height() ), pixmap );
+    painter.drawPixmap(QPointF(0.5 * ( width() - pixmapSize.width() ), 0.5 * ( height() - pixmapSize.height() )), pixmap );
 }
 
 void ProgressCircle::setInfiniteAnimationValue(qreal value)
 {
+    const int oldFrame = infiniteAnimationFrame();
     mInfiniteAnimationValue = value;
-    update();
+
+    // repaint only if animation reached the next pre-rendered frame
+    if (mMaximum == 0 && oldFrame != infiniteAnimationFrame())
+        update();
+}
+
+int ProgressCircle::infiniteAnimationFrame() const
+{
+    return qRound(mInfiniteAnimationValue * infiniteAnimationFrames) % infiniteAnimationFrames;
 }
 
 void ProgressCircle::setVisibleValue(int value)
@@ -165,29 +182,33 @@ void ProgressCircle::setVisibleValue(int value)
     }
 }
 
-QString ProgressCircle::key() const
+QString ProgressCircle::key(qreal dpr) const
 {
-    return QString("%1,%2,%3,%4,%5,%6,%7,%8")
-            .arg(mInfiniteAnimationValue)
-            .arg(mVisibleValue)
+    // don't put animation state that is not drawn into the key
+    return QString("ProgressCircle:%1,%2,%3,%4,%5,%6,%7,%8,%9")
+            .arg((mMaximum == 0) ? infiniteAnimationFrame() : 0)
+            .arg((mMaximum == 0) ? 0 : qMin(mVisibleValue, mMaximum))
             .arg(mMaximum)
             .arg(mInnerRadius)
             .arg(mOuterRadius)
             .arg(width())
             .arg(height())
             .arg(mColor.rgb())
+            .arg(dpr)
             ;
 }
 
-QPixmap ProgressCircle::generatePixmap() const
+QPixmap ProgressCircle::generatePixmap(qreal dpr) const
 {
-    QPixmap pixmap(squared(rect()).size().toSize());
+    const QSize size = squared(rect()).size().toSize();
+    QPixmap pixmap(size * dpr);
+    pixmap.setDevicePixelRatio(dpr);
     pixmap.fill(QColor(0,0,0,0));
     QPainter painter(&pixmap);
 
     painter.setRenderHint(QPainter::Antialiasing, true);
 
-    QRectF rect = pixmap.rect().adjusted(1,1,-1,-1);
+    QRectF rect = QRectF(QPointF(0, 0), size).adjusted(1,1,-1,-1);
     qreal margin = rect.width()*(1.0 - mOuterRadius)/2.0;
     rect.adjust(margin,margin,-margin,-margin);
     qreal innerRadius = mInnerRadius*rect.width()/2.0;
@@ -203,7 +224,7 @@ QPixmap ProgressCircle::generatePixmap() const
     if(mMaximum == 0)
     {
         //draw as infinite process
-        int startAngle = -mInfiniteAnimationValue * 360 * 16;
+        int startAngle = -qreal(infiniteAnimationFrame()) * 360 * 16 / infiniteAnimationFrames;
         int spanAngle = 0.15 * 360 * 16;
         painter.drawPie(rect, startAngle, spanAngle);
     }
@@ -69,9 +69,10 @@ private slots:
     void setVisibleValue(int value);
 
 private:
-    QString key() const;
-    QPixmap generatePixmap() const;
+    QString key(qreal dpr) const;
+    QPixmap generatePixmap(qreal dpr) const;
     qreal infiniteAnimationValue() const;
+    int infiniteAnimationFrame() const;
     int visibleValue() const;
     
 private:
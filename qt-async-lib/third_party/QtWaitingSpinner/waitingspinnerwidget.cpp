@@ -29,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 // Qt includes
 #include <QPainter>
+#include <QPixmapCache>
 #include <QTimer>
 
 WaitingSpinnerWidget::WaitingSpinnerWidget(QWidget *parent,
@@ -69,6 +70,7 @@ void WaitingSpinnerWidget::initialize() {
     _innerRadius = 10;
     _currentCounter = 0;
     _isSpinning = false;
+    _frameKeyDpr = 1.0;
 
     _timer = new QTimer(this);
     connect(_timer, SIGNAL(timeout()), this, SLOT(rotate()));
@@ -81,24 +83,50 @@ void WaitingSpinnerWidget::paintEvent(QPaintEvent *) {
     updatePosition();
     QPainter painter(this);
     painter.fillRect(this->rect(), Qt::transparent);
-    painter.setRenderHint(QPainter::Antialiasing, true);
 
     if (_currentCounter >= _numberOfLines) {
         _currentCounter = 0;
     }
 
+    // frames are shared between all spinners with the same look
+    const qreal dpr = devicePixelRatioF();
+    if (_frameKeyPrefix.isEmpty() || _frameKeyDpr != dpr) {
+        updateFrameKeyPrefix(dpr);
+    }
+
+    QPixmap frame;
+    const QString frameKey = _frameKeyPrefix + QString::number(_currentCounter);
+    if (!QPixmapCache::find(frameKey, &frame)) {
+        frame = generateFrame(_currentCounter, dpr);
+        QPixmapCache::insert(frameKey, frame);
+    }
+    painter.drawPixmap((width() - _imageSize.width()) / 2, 0, frame);
+
+    if (!_text.isEmpty()) {
+        painter.setPen(QPen(_textColor));
+        painter.drawText(QRect(0, _imageSize.height(), width(), height() - _imageSize.height()), 
+                Qt::AlignBottom | Qt::AlignHCenter, _text);
+    }
+}
+
+QPixmap WaitingSpinnerWidget::generateFrame(int counter, qreal dpr) const {
+    QPixmap frame(_imageSize * dpr);
+    frame.setDevicePixelRatio(dpr);
+    frame.fill(Qt::transparent);
+
+    QPainter painter(&frame);
+    painter.setRenderHint(QPainter::Antialiasing, true);
     painter.setPen(Qt::NoPen);
     for (int i = 0; i < _numberOfLines; ++i) {
         painter.save();
         painter.translate(_innerRadius + _lineLength,
                           _innerRadius + _lineLength);
-        painter.translate((width() - _imageSize.width()) / 2, 0);
         qreal rotateAngle =
                 static_cast<qreal>(360 * i) / static_cast<qreal>(_numberOfLines);
         painter.rotate(rotateAngle);
         painter.translate(_innerRadius, 0);
         int distance =
-                lineCountDistanceFromPrimary(i, _currentCounter, _numberOfLines);
+                lineCountDistanceFromPrimary(i, counter, _numberOfLines);
         QColor color =
                 currentLineColor(distance, _numberOfLines, _trailFadePercentage,
                                  _minimumTrailOpacity, _color);
@@ -110,11 +138,26 @@ void WaitingSpinnerWidget::paintEvent(QPaintEvent *) {
         painter.restore();
     }
 
-    if (!_text.isEmpty()) {
-        painter.setPen(QPen(_textColor));
-        painter.drawText(QRect(0, _imageSize.height(), width(), height() - _imageSize.height()), 
-                Qt::AlignBottom | Qt::AlignHCenter, _text);
-    }
+    return frame;
+}
+
+void WaitingSpinnerWidget::updateFrameKeyPrefix(qreal dpr) {
+    _frameKeyDpr = dpr;
+    _frameKeyPrefix = QString("WaitingSpinner:%1,%2,%3,%4,%5,%6,%7,%8,%9:")
+            .arg(_color.rgba())
+            .arg(_roundness)
+            .arg(_minimumTrailOpacity)
+            .arg(_trailFadePercentage)
+            .arg(_numberOfLines)
+            .arg(_lineLength)
+            .arg(_lineWidth)
+            .arg(_innerRadius)
+            .arg(dpr);
+}
+
+void WaitingSpinnerWidget::invalidateFrames() {
+    _frameKeyPrefix.clear();
+    update();
 }
 
 void WaitingSpinnerWidget::start() {
@@ -150,21 +193,25 @@ void WaitingSpinnerWidget::setNumberOfLines(int lines) {
     _numberOfLines = lines;
     _currentCounter = 0;
     updateTimer();
+    invalidateFrames();
 }
 
 void WaitingSpinnerWidget::setLineLength(int length) {
     _lineLength = length;
     updateSize();
+    invalidateFrames();
 }
 
 void WaitingSpinnerWidget::setLineWidth(int width) {
     _lineWidth = width;
     updateSize();
+    invalidateFrames();
 }
 
 void WaitingSpinnerWidget::setInnerRadius(int radius) {
     _innerRadius = radius;
     updateSize();
+    invalidateFrames();
 }
 
 void WaitingSpinnerWidget::setText(QString text) {
@@ -222,10 +269,12 @@ bool WaitingSpinnerWidget::isSpinning() const {
 
 void WaitingSpinnerWidget::setRoundness(qreal roundness) {
     _roundness = std::max(0.0, std::min(100.0, roundness));
+    invalidateFrames();
 }
 
 void WaitingSpinnerWidget::setColor(QColor color) {
     _color = color;
+    invalidateFrames();
 }
 
 void WaitingSpinnerWidget::setTextColor(QColor color) {
@@ -239,10 +288,12 @@ void WaitingSpinnerWidget::setRevolutionsPerSecond(qreal revolutionsPerSecond) {
 
 void WaitingSpinnerWidget::setTrailFadePercentage(qreal trail) {
     _trailFadePercentage = trail;
+    invalidateFrames();
 }
 
 void WaitingSpinnerWidget::setMinimumTrailOpacity(qreal minimumTrailOpacity) {
     _minimumTrailOpacity = minimumTrailOpacity;
+    invalidateFrames();
 }
 
 void WaitingSpinnerWidget::rotate() {
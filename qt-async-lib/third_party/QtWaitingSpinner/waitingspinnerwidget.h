@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <QWidget>
 #include <QTimer>
 #include <QColor>
+#include <QPixmap>
 
 class WaitingSpinnerWidget : public QWidget {
     Q_OBJECT
@@ -90,6 +91,9 @@ private:
                                    QColor color);
 
     void initialize();
+    QPixmap generateFrame(int counter, qreal dpr) const;
+    void updateFrameKeyPrefix(qreal dpr);
+    void invalidateFrames();
     void updateSize();
     void updateTimer();
     void updatePosition();
@@ -107,6 +111,8 @@ private:
     QString _text;
     QSize   _imageSize;
     QColor  _textColor;
+    QString _frameKeyPrefix;
+    qreal   _frameKeyDpr;
 
 private:
     WaitingSpinnerWidget(const WaitingSpinnerWidget&);
@@ -0,0 +1,111 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncDiskCache.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+static const quint32 entryMagic = 0x41444331; // "ADC1"
+static const QDataStream::Version streamVersion = QDataStream::Qt_5_6;
+
+AsyncDiskCache::AsyncDiskCache(QString directory)
+    : m_directory(std::move(directory))
+{
+    QDir().mkpath(m_directory);
+    m_writers.setMaxThreadCount(1);
+}
+
+AsyncDiskCache::~AsyncDiskCache()
+{
+    flush();
+}
+
+bool AsyncDiskCache::read(const QString& key, quint32 version, const ReadFnType& reader) const
+{
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    auto size = file.size();
+    auto data = file.map(0, size);
+    if (!data)
+        return false;
+
+    // stream reads mapped pages directly
+    auto bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(size));
+    QDataStream stream(bytes);
+    stream.setVersion(streamVersion);
+
+    quint32 magic = 0;
+    QString entryKey;
+    quint32 entryVersion = 0;
+    stream >> magic >> entryKey >> entryVersion;
+
+    // different key means hash collision
+    if (stream.status() != QDataStream::Ok || magic != entryMagic || entryKey != key || entryVersion != version)
+        return false;
+
+    reader(stream);
+
+    return stream.status() == QDataStream::Ok;
+}
+
+void AsyncDiskCache::write(const QString& key, quint32 version, WriteFnType writer)
+{
+    AsyncRunnable::start(&m_writers, [this, key, version, writer = std::move(writer)]() {
+        writeEntry(key, version, writer);
+    });
+}
+
+void AsyncDiskCache::remove(const QString& key)
+{
+    // don't race with pending write of the key
+    flush();
+    QFile::remove(filePath(key));
+}
+
+void AsyncDiskCache::flush()
+{
+    m_writers.waitForDone();
+}
+
+QString AsyncDiskCache::filePath(const QString& key) const
+{
+    auto hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(hash) + QLatin1String(".adc");
+}
+
+void AsyncDiskCache::writeEntry(const QString& key, quint32 version, const WriteFnType& writer) const
+{
+    // readers see either previous or new file
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "AsyncDiskCache: cannot write" << file.fileName() << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(streamVersion);
+    stream << entryMagic << key << version;
+    writer(stream);
+
+    if (stream.status() != QDataStream::Ok || !file.commit())
+        qWarning() << "AsyncDiskCache: cannot write" << file.fileName() << file.errorString();
+}
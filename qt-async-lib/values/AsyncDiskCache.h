@@ -0,0 +1,79 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_DISK_CACHE_H
+#define ASYNC_DISK_CACHE_H
+
+#include <QDataStream>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+#include "AsyncRunnable.h"
+
+// persistent storage of calculated values
+// every entry is kept in a separate file named by key hash together with the key and version
+// entries are read through memory mapping and written by a background thread
+// values are serialized by QDataStream operators
+class AsyncDiskCache
+{
+    Q_DISABLE_COPY(AsyncDiskCache)
+
+public:
+    using ReadFnType = std::function<void(QDataStream&)>;
+    using WriteFnType = std::function<void(QDataStream&)>;
+
+    explicit AsyncDiskCache(QString directory);
+    // waits for pending writes
+    ~AsyncDiskCache();
+
+    QString directory() const { return m_directory; }
+
+    // returns false if entry is missing, has different version or cannot be read
+    template <typename T>
+    bool load(const QString& key, quint32 version, T& value) const
+    {
+        return read(key, version, [&value](QDataStream& stream) {
+            stream >> value;
+        });
+    }
+
+    // value is copied and serialized in background
+    template <typename T>
+    void store(const QString& key, quint32 version, T value)
+    {
+        write(key, version, [value = std::move(value)](QDataStream& stream) {
+            stream << value;
+        });
+    }
+
+    bool read(const QString& key, quint32 version, const ReadFnType& reader) const;
+    void write(const QString& key, quint32 version, WriteFnType writer);
+
+    void remove(const QString& key);
+
+    // waits until all stored values are written
+    void flush();
+
+private:
+    QString filePath(const QString& key) const;
+    void writeEntry(const QString& key, quint32 version, const WriteFnType& writer) const;
+
+    const QString m_directory;
+    // single writer keeps the order of writes of the same key
+    QThreadPool m_writers;
+};
+
+#endif // ASYNC_DISK_CACHE_H
@@ -0,0 +1,178 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncEviction.h"
+#include <QImage>
+#include <QPixmap>
+
+qint64 asyncValueByteSize(const QImage& image)
+{
+    return sizeof(QImage) + qint64(image.bytesPerLine()) * image.height();
+}
+
+qint64 asyncValueByteSize(const QPixmap& pixmap)
+{
+    return sizeof(QPixmap) + qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+AsyncEvictionManager::AsyncEvictionManager(qint64 budget)
+    : m_budget(budget)
+{
+}
+
+AsyncEvictionManager::~AsyncEvictionManager()
+{
+    Q_ASSERT(!m_head && "All evictable values should be destroyed before the manager");
+}
+
+AsyncEvictionManager* AsyncEvictionManager::global()
+{
+    // never destroyed, so values may outlive static objects
+    static auto manager = new AsyncEvictionManager();
+    return manager;
+}
+
+qint64 AsyncEvictionManager::budget() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_budget;
+}
+
+void AsyncEvictionManager::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_lock);
+    m_budget = bytes;
+    evictOverBudget(locker);
+}
+
+qint64 AsyncEvictionManager::usedBytes() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_usedBytes;
+}
+
+int AsyncEvictionManager::trackedCount() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_trackedCount;
+}
+
+quint64 AsyncEvictionManager::evictedCount() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_evictedCount;
+}
+
+void AsyncEvictionManager::update(AsyncEvictableEntry* entry, qint64 bytes)
+{
+    Q_ASSERT(entry);
+
+    QMutexLocker locker(&m_lock);
+
+    if (entry->m_isTracked)
+        unlink(entry);
+
+    entry->m_bytes = bytes;
+    // new content is considered as used
+    entry->m_referenced.storeRelease(1);
+    link(entry);
+
+    evictOverBudget(locker);
+}
+
+void AsyncEvictionManager::remove(AsyncEvictableEntry* entry)
+{
+    Q_ASSERT(entry);
+
+    QMutexLocker locker(&m_lock);
+
+    while (m_evicting == entry)
+        m_evictionDone.wait(&m_lock);
+
+    if (entry->m_isTracked)
+        unlink(entry);
+}
+
+void AsyncEvictionManager::link(AsyncEvictableEntry* entry)
+{
+    Q_ASSERT(!entry->m_isTracked);
+
+    entry->m_prev = nullptr;
+    entry->m_next = m_head;
+    if (m_head)
+        m_head->m_prev = entry;
+    else
+        m_tail = entry;
+    m_head = entry;
+
+    entry->m_isTracked = true;
+    m_usedBytes += entry->m_bytes;
+    m_trackedCount += 1;
+}
+
+void AsyncEvictionManager::unlink(AsyncEvictableEntry* entry)
+{
+    Q_ASSERT(entry->m_isTracked);
+
+    if (entry->m_prev)
+        entry->m_prev->m_next = entry->m_next;
+    else
+        m_head = entry->m_next;
+
+    if (entry->m_next)
+        entry->m_next->m_prev = entry->m_prev;
+    else
+        m_tail = entry->m_prev;
+
+    entry->m_prev = nullptr;
+    entry->m_next = nullptr;
+
+    entry->m_isTracked = false;
+    m_usedBytes -= entry->m_bytes;
+    m_trackedCount -= 1;
+}
+
+void AsyncEvictionManager::evictOverBudget(QMutexLocker& locker)
+{
+    // only one thread evicts at a time, it evicts until usage fits the budget
+    if (m_evicting)
+        return;
+
+    // the most recently used entry is never evicted
+    while (m_usedBytes > m_budget && m_tail && m_tail != m_head)
+    {
+        auto victim = m_tail;
+        unlink(victim);
+
+        // recently accessed entry gets second chance
+        if (victim->m_referenced.fetchAndStoreOrdered(0))
+        {
+            link(victim);
+            continue;
+        }
+
+        m_evicting = victim;
+        m_evictedCount += 1;
+
+        // evictImpl locks the value and may emit signals
+        locker.unlock();
+        victim->evictImpl();
+        locker.relock();
+
+        m_evicting = nullptr;
+        m_evictionDone.wakeAll();
+    }
+}
@@ -0,0 +1,143 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_EVICTION_H
+#define ASYNC_EVICTION_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <limits>
+#include <vector>
+
+class QImage;
+class QPixmap;
+
+// approximate memory used by the value
+// add overloads for own types to make eviction budget precise
+template <typename T>
+qint64 asyncValueByteSize(const T&)
+{
+    return sizeof(T);
+}
+
+inline qint64 asyncValueByteSize(const QString& value)
+{
+    return sizeof(QString) + value.capacity() * sizeof(QChar);
+}
+
+inline qint64 asyncValueByteSize(const QByteArray& value)
+{
+    return sizeof(QByteArray) + value.capacity();
+}
+
+qint64 asyncValueByteSize(const QImage& image);
+qint64 asyncValueByteSize(const QPixmap& pixmap);
+
+template <typename T>
+qint64 asyncValueByteSize(const QVector<T>& values)
+{
+    return sizeof(QVector<T>) + qint64(values.capacity()) * sizeof(T);
+}
+
+template <typename T>
+qint64 asyncValueByteSize(const std::vector<T>& values)
+{
+    return sizeof(std::vector<T>) + qint64(values.capacity()) * sizeof(T);
+}
+
+class AsyncEvictionManager;
+
+// value that can be evicted by AsyncEvictionManager
+class AsyncEvictableEntry
+{
+    friend class AsyncEvictionManager;
+
+public:
+    AsyncEvictableEntry() = default;
+    virtual ~AsyncEvictableEntry() = default;
+
+protected:
+    // drops content, called by eviction manager without locks
+    virtual void evictImpl() = 0;
+
+private:
+    AsyncEvictableEntry* m_prev = nullptr;
+    AsyncEvictableEntry* m_next = nullptr;
+    qint64 m_bytes = 0;
+    bool m_isTracked = false;
+    // set on access, cleared when entry gets second chance
+    QAtomicInt m_referenced;
+};
+
+// keeps least recently used list of evictable values
+// and evicts the oldest ones when their total size exceeds the budget
+// accessed entries are only marked, they are moved to the list head
+// by eviction instead of being evicted (second chance), so access doesn't lock the manager
+class AsyncEvictionManager
+{
+    Q_DISABLE_COPY(AsyncEvictionManager)
+
+public:
+    explicit AsyncEvictionManager(qint64 budget = std::numeric_limits<qint64>::max());
+    ~AsyncEvictionManager();
+
+    // manager used by evictable values by default
+    static AsyncEvictionManager* global();
+
+    qint64 budget() const;
+    void setBudget(qint64 bytes);
+
+    qint64 usedBytes() const;
+    int trackedCount() const;
+    // total number of evictions
+    quint64 evictedCount() const;
+
+    // starts tracking of the entry (or updates its size) as the most recently used one
+    void update(AsyncEvictableEntry* entry, qint64 bytes);
+    // marks entry as recently used
+    void touch(AsyncEvictableEntry* entry)
+    {
+        entry->m_referenced.storeRelease(1);
+    }
+    // stops tracking, waits if the entry is being evicted right now
+    void remove(AsyncEvictableEntry* entry);
+
+private:
+    void link(AsyncEvictableEntry* entry);
+    void unlink(AsyncEvictableEntry* entry);
+    void evictOverBudget(QMutexLocker& locker);
+
+    mutable QMutex m_lock;
+    QWaitCondition m_evictionDone;
+
+    qint64 m_budget;
+    qint64 m_usedBytes = 0;
+    int m_trackedCount = 0;
+    quint64 m_evictedCount = 0;
+
+    // m_head is the most recently used entry, m_tail is the least recently used one
+    AsyncEvictableEntry* m_head = nullptr;
+    AsyncEvictableEntry* m_tail = nullptr;
+
+    // entry evictImpl is called for
+    AsyncEvictableEntry* m_evicting = nullptr;
+};
+
+#endif // ASYNC_EVICTION_H
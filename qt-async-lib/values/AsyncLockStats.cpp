@@ -0,0 +1,278 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncLockStats.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHash>
+#include <QTextStream>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#ifdef ASYNC_LOCK_STATS
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+namespace
+{
+
+QString typeName(const std::type_info& type)
+{
+#ifdef __GNUG__
+    int status = 0;
+    std::unique_ptr<char, void(*)(void*)> demangled(abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+    if (status == 0 && demangled)
+        return QString::fromLatin1(demangled.get());
+#endif
+    return QString::fromLatin1(type.name());
+}
+
+QString lockName(ASYNC_LOCK lock)
+{
+    switch (lock)
+    {
+    case ASYNC_LOCK::WRITE: return QStringLiteral("m_writeLock");
+    case ASYNC_LOCK::CONTENT: return QStringLiteral("m_contentLock");
+    case ASYNC_LOCK::PROGRESS: return QStringLiteral("m_lock");
+    }
+    return QString();
+}
+
+void updateMax(QAtomicInteger<quint64>& maxValue, quint64 value)
+{
+    auto current = maxValue.loadAcquire();
+    while (current < value && !maxValue.testAndSetOrdered(current, value, current)) {}
+}
+
+int histogramBucket(quint64 waitNs)
+{
+    auto waitUs = waitNs / 1000;
+    int bucket = 0;
+    while (waitUs > 0 && bucket < ASYNC_LOCK_STATS_BUCKETS - 1)
+    {
+        waitUs >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+struct StatsData
+{
+    QMutex lock;
+    // entries live until application exits
+    // because asyncLockStats() caches references to them
+    std::vector<std::unique_ptr<AsyncLockStatsEntry>> entries;
+    QHash<QString, AsyncLockStatsEntry*> entriesByName;
+    bool dumpOnExit = true;
+    bool dumpRegistered = false;
+};
+
+Q_GLOBAL_STATIC(StatsData, statsData)
+
+void dumpStats()
+{
+    if (statsData()->dumpOnExit)
+        qInfo().noquote() << AsyncLockStats::dump();
+}
+
+} // end anonymous namespace
+
+AsyncLockStatsEntry::AsyncLockStatsEntry(QString name)
+    : m_name(std::move(name))
+{
+}
+
+void AsyncLockStatsEntry::record(qint64 waitNs, qint64 holdNs)
+{
+    m_acquisitions.fetchAndAddRelaxed(1);
+    if (waitNs >= 1000)
+        m_contentions.fetchAndAddRelaxed(1);
+    m_totalWaitNs.fetchAndAddRelaxed(quint64(waitNs));
+    m_totalHoldNs.fetchAndAddRelaxed(quint64(holdNs));
+    m_waitHistogram[size_t(histogramBucket(quint64(waitNs)))].fetchAndAddRelaxed(1);
+    updateMax(m_maxWaitNs, quint64(waitNs));
+    updateMax(m_maxHoldNs, quint64(holdNs));
+}
+
+AsyncLockStatsSnapshot AsyncLockStatsEntry::snapshot() const
+{
+    AsyncLockStatsSnapshot result;
+    result.name = m_name;
+    result.acquisitions = m_acquisitions.loadAcquire();
+    result.contentions = m_contentions.loadAcquire();
+    result.totalWaitNs = m_totalWaitNs.loadAcquire();
+    result.maxWaitNs = m_maxWaitNs.loadAcquire();
+    result.totalHoldNs = m_totalHoldNs.loadAcquire();
+    result.maxHoldNs = m_maxHoldNs.loadAcquire();
+    result.waitHistogram.reserve(ASYNC_LOCK_STATS_BUCKETS);
+    for (const auto& bucket : m_waitHistogram)
+        result.waitHistogram.append(bucket.loadAcquire());
+    return result;
+}
+
+void AsyncLockStatsEntry::reset()
+{
+    m_acquisitions.storeRelease(0);
+    m_contentions.storeRelease(0);
+    m_totalWaitNs.storeRelease(0);
+    m_maxWaitNs.storeRelease(0);
+    m_totalHoldNs.storeRelease(0);
+    m_maxHoldNs.storeRelease(0);
+    for (auto& bucket : m_waitHistogram)
+        bucket.storeRelease(0);
+}
+
+bool AsyncLockStats::isEnabled()
+{
+    return true;
+}
+
+AsyncLockStatsEntry& AsyncLockStats::entry(const std::type_info& type, ASYNC_LOCK lock)
+{
+    auto name = QString("%1::%2").arg(typeName(type), lockName(lock));
+
+    auto data = statsData();
+    QMutexLocker locker(&data->lock);
+
+    auto it = data->entriesByName.find(name);
+    if (it != data->entriesByName.end())
+        return **it;
+
+    if (!data->dumpRegistered)
+    {
+        data->dumpRegistered = true;
+        qAddPostRoutine(dumpStats);
+    }
+
+    data->entries.push_back(std::make_unique<AsyncLockStatsEntry>(name));
+    auto entry = data->entries.back().get();
+    data->entriesByName.insert(name, entry);
+    return *entry;
+}
+
+QVector<AsyncLockStatsSnapshot> AsyncLockStats::snapshot()
+{
+    QVector<AsyncLockStatsSnapshot> result;
+
+    auto data = statsData();
+    QMutexLocker locker(&data->lock);
+
+    result.reserve(int(data->entries.size()));
+    for (const auto& entry : data->entries)
+        result.append(entry->snapshot());
+
+    return result;
+}
+
+void AsyncLockStats::reset()
+{
+    auto data = statsData();
+    QMutexLocker locker(&data->lock);
+
+    for (const auto& entry : data->entries)
+        entry->reset();
+}
+
+void AsyncLockStats::setDumpOnExit(bool dumpOnExit)
+{
+    auto data = statsData();
+    QMutexLocker locker(&data->lock);
+
+    data->dumpOnExit = dumpOnExit;
+}
+
+#else
+
+bool AsyncLockStats::isEnabled()
+{
+    return false;
+}
+
+AsyncLockStatsEntry& AsyncLockStats::entry(const std::type_info&, ASYNC_LOCK)
+{
+    static AsyncLockStatsEntry none;
+    return none;
+}
+
+QVector<AsyncLockStatsSnapshot> AsyncLockStats::snapshot()
+{
+    return QVector<AsyncLockStatsSnapshot>();
+}
+
+void AsyncLockStats::reset()
+{
+}
+
+void AsyncLockStats::setDumpOnExit(bool)
+{
+}
+
+#endif // ASYNC_LOCK_STATS
+
+QString AsyncLockStats::dump()
+{
+    auto stats = snapshot();
+    std::sort(stats.begin(), stats.end(), [](const AsyncLockStatsSnapshot& left, const AsyncLockStatsSnapshot& right) {
+        return left.totalWaitNs > right.totalWaitNs;
+    });
+
+    QString result;
+    QTextStream out(&result);
+
+    out << "Async lock stats";
+    if (!isEnabled())
+        out << " (disabled, define ASYNC_LOCK_STATS to collect)";
+    out << "\n";
+
+    for (const auto& stat : stats)
+    {
+        if (stat.acquisitions == 0)
+            continue;
+
+        out << stat.name << "\n"
+            << "  acquisitions: " << stat.acquisitions
+            << ", contended: " << stat.contentions
+            << ", wait total/avg/max us: " << stat.totalWaitNs / 1000
+            << "/" << double(stat.totalWaitNs) / stat.acquisitions / 1000.
+            << "/" << stat.maxWaitNs / 1000
+            << ", hold total/avg/max us: " << stat.totalHoldNs / 1000
+            << "/" << double(stat.totalHoldNs) / stat.acquisitions / 1000.
+            << "/" << stat.maxHoldNs / 1000 << "\n";
+
+        out << "  wait histogram:";
+        for (int i = 0; i < stat.waitHistogram.size(); ++i)
+        {
+            if (stat.waitHistogram[i] == 0)
+                continue;
+
+            if (i == 0)
+                out << " <1us:";
+            else if (i == stat.waitHistogram.size() - 1)
+                out << " >=" << (quint64(1) << (i - 1)) << "us:";
+            else
+                out << " <" << (quint64(1) << i) << "us:";
+            out << stat.waitHistogram[i];
+        }
+        out << "\n";
+    }
+
+    out.flush();
+    return result;
+}
@@ -0,0 +1,190 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_LOCK_STATS_H
+#define ASYNC_LOCK_STATS_H
+
+#include "../Config.h"
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+#include <typeinfo>
+
+enum class ASYNC_LOCK
+{
+    WRITE,      // AsyncValueBase::m_writeLock
+    CONTENT,    // AsyncValueBase::m_contentLock
+    PROGRESS    // AsyncProgress::m_lock
+};
+
+// wait time histogram buckets: [0, 1us), [1us, 2us), [2us, 4us) ... [2^(N-2)us, inf)
+#define ASYNC_LOCK_STATS_BUCKETS 24
+
+struct AsyncLockStatsSnapshot
+{
+    // "<type>::<lock>"
+    QString name;
+    quint64 acquisitions = 0;
+    // acquisitions waited for 1us or longer
+    quint64 contentions = 0;
+    quint64 totalWaitNs = 0;
+    quint64 maxWaitNs = 0;
+    quint64 totalHoldNs = 0;
+    quint64 maxHoldNs = 0;
+    QVector<quint64> waitHistogram;
+};
+
+class AsyncLockStatsEntry;
+
+// collects statistics of async values locks
+// works only if ASYNC_LOCK_STATS is defined (see Config.h)
+class AsyncLockStats
+{
+public:
+    static bool isEnabled();
+
+    // returns entry for the lock of the type, creates it if needed
+    static AsyncLockStatsEntry& entry(const std::type_info& type, ASYNC_LOCK lock);
+
+    static QVector<AsyncLockStatsSnapshot> snapshot();
+    static void reset();
+
+    // returns human readable table sorted by total wait time
+    static QString dump();
+    // prints dump() at application exit (on by default)
+    static void setDumpOnExit(bool dumpOnExit);
+};
+
+#ifdef ASYNC_LOCK_STATS
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <array>
+
+class AsyncLockStatsEntry
+{
+    Q_DISABLE_COPY(AsyncLockStatsEntry)
+
+public:
+    explicit AsyncLockStatsEntry(QString name);
+
+    void record(qint64 waitNs, qint64 holdNs);
+    AsyncLockStatsSnapshot snapshot() const;
+    void reset();
+
+private:
+    const QString m_name;
+
+    QAtomicInteger<quint64> m_acquisitions;
+    QAtomicInteger<quint64> m_contentions;
+    QAtomicInteger<quint64> m_totalWaitNs;
+    QAtomicInteger<quint64> m_maxWaitNs;
+    QAtomicInteger<quint64> m_totalHoldNs;
+    QAtomicInteger<quint64> m_maxHoldNs;
+    std::array<QAtomicInteger<quint64>, ASYNC_LOCK_STATS_BUCKETS> m_waitHistogram;
+};
+
+template <typename Type, ASYNC_LOCK lock>
+AsyncLockStatsEntry& asyncLockStats()
+{
+    static AsyncLockStatsEntry& entry = AsyncLockStats::entry(typeid(Type), lock);
+    return entry;
+}
+
+// measures how long the lock was waited for and held
+template <typename Locker, typename Lock>
+class AsyncLockerStats
+{
+    Q_DISABLE_COPY(AsyncLockerStats)
+
+public:
+    AsyncLockerStats(Lock* lock, AsyncLockStatsEntry& entry)
+        : m_entry(entry),
+          m_timer(startedTimer()),
+          m_locker(lock),
+          m_waitNs(m_timer.nsecsElapsed())
+    {
+    }
+
+    ~AsyncLockerStats()
+    {
+        unlock();
+    }
+
+    // releases the lock before the locker goes out of scope
+    void unlock()
+    {
+        if (m_unlocked)
+            return;
+
+        // don't count recording time as holding time
+        m_locker.unlock();
+        m_unlocked = true;
+        m_entry.record(m_waitNs, m_timer.nsecsElapsed() - m_waitNs);
+    }
+
+private:
+    static QElapsedTimer startedTimer()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }
+
+    AsyncLockStatsEntry& m_entry;
+    QElapsedTimer m_timer;
+    Locker m_locker;
+    qint64 m_waitNs;
+    bool m_unlocked = false;
+};
+
+using AsyncMutexLocker = AsyncLockerStats<QMutexLocker, QMutex>;
+using AsyncReadLocker = AsyncLockerStats<QReadLocker, QReadWriteLock>;
+using AsyncWriteLocker = AsyncLockerStats<QWriteLocker, QReadWriteLock>;
+
+#else
+
+// zero cost stubs
+class AsyncLockStatsEntry {};
+
+template <typename Type, ASYNC_LOCK lock>
+AsyncLockStatsEntry asyncLockStats()
+{
+    return AsyncLockStatsEntry();
+}
+
+class AsyncMutexLocker : public QMutexLocker
+{
+public:
+    AsyncMutexLocker(QMutex* lock, const AsyncLockStatsEntry&) : QMutexLocker(lock) {}
+};
+
+class AsyncReadLocker : public QReadLocker
+{
+public:
+    AsyncReadLocker(QReadWriteLock* lock, const AsyncLockStatsEntry&) : QReadLocker(lock) {}
+};
+
+class AsyncWriteLocker : public QWriteLocker
+{
+public:
+    AsyncWriteLocker(QReadWriteLock* lock, const AsyncLockStatsEntry&) : QWriteLocker(lock) {}
+};
+
+#endif // ASYNC_LOCK_STATS
+
+#endif // ASYNC_LOCK_STATS_H
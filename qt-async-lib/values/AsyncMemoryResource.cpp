@@ -0,0 +1,281 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncMemoryResource.h"
+#include <QMutexLocker>
+#include <array>
+#include <vector>
+
+namespace
+{
+
+thread_local AsyncMemoryResource* threadDefaultResource = nullptr;
+
+void* upstreamAllocate(AsyncMemoryResource* upstream, size_t bytes, size_t alignment)
+{
+    if (upstream)
+        return upstream->allocate(bytes, alignment);
+
+    Q_ASSERT(alignment <= alignof(std::max_align_t) && "Over aligned allocations are not supported");
+    return ::operator new(bytes);
+}
+
+void upstreamDeallocate(AsyncMemoryResource* upstream, void* p, size_t bytes, size_t alignment)
+{
+    if (upstream)
+        upstream->deallocate(p, bytes, alignment);
+    else
+        ::operator delete(p);
+}
+
+// size classes of AsyncThreadPoolsResource: 16, 32 ... 1024 bytes
+const size_t minBlockSize = 16;
+const int blockClasses = 7;
+// blocks moved between thread cache and global lists at once
+const int blocksBatch = 32;
+// thread keeps at most this number of free blocks of every size class
+const int maxCachedBlocks = 2 * blocksBatch;
+
+int blockClass(size_t bytes)
+{
+    int blockClass = 0;
+    size_t blockSize = minBlockSize;
+    while (blockSize < bytes)
+    {
+        blockSize <<= 1;
+        ++blockClass;
+    }
+    return blockClass;
+}
+
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+struct FreeList
+{
+    FreeBlock* head = nullptr;
+    int count = 0;
+
+    void push(FreeBlock* block)
+    {
+        block->next = head;
+        head = block;
+        ++count;
+    }
+
+    FreeBlock* pop()
+    {
+        auto block = head;
+        head = block->next;
+        --count;
+        return block;
+    }
+};
+
+struct GlobalPools
+{
+    ~GlobalPools()
+    {
+        for (auto slab : slabs)
+            ::operator delete(slab);
+    }
+
+    QMutex lock;
+    std::array<FreeList, blockClasses> freeLists;
+    std::vector<void*> slabs;
+};
+
+Q_GLOBAL_STATIC(GlobalPools, globalPools)
+
+struct ThreadCache
+{
+    ~ThreadCache()
+    {
+        // return blocks of finished thread to global lists
+        if (globalPools.isDestroyed())
+            return;
+
+        auto pools = globalPools();
+        QMutexLocker locker(&pools->lock);
+        for (int i = 0; i < blockClasses; ++i)
+        {
+            while (freeLists[size_t(i)].count > 0)
+                pools->freeLists[size_t(i)].push(freeLists[size_t(i)].pop());
+        }
+    }
+
+    std::array<FreeList, blockClasses> freeLists;
+};
+
+thread_local ThreadCache threadCache;
+
+class AsyncThreadPoolsResource : public AsyncMemoryResource
+{
+protected:
+    void* allocateImpl(size_t bytes, size_t alignment) override
+    {
+        if (bytes > (minBlockSize << (blockClasses - 1)) || alignment > alignof(std::max_align_t))
+            return upstreamAllocate(nullptr, bytes, alignment);
+
+        auto index = blockClass(bytes);
+        auto& freeList = threadCache.freeLists[size_t(index)];
+        if (freeList.count == 0)
+            refill(freeList, index);
+
+        return freeList.pop();
+    }
+
+    void deallocateImpl(void* p, size_t bytes, size_t alignment) override
+    {
+        if (bytes > (minBlockSize << (blockClasses - 1)) || alignment > alignof(std::max_align_t))
+        {
+            upstreamDeallocate(nullptr, p, bytes, alignment);
+            return;
+        }
+
+        // slabs are released already
+        if (globalPools.isDestroyed())
+            return;
+
+        auto index = blockClass(bytes);
+        auto& freeList = threadCache.freeLists[size_t(index)];
+        freeList.push(static_cast<FreeBlock*>(p));
+
+        if (freeList.count > maxCachedBlocks)
+        {
+            auto pools = globalPools();
+            QMutexLocker locker(&pools->lock);
+            for (int i = 0; i < blocksBatch; ++i)
+                pools->freeLists[size_t(index)].push(freeList.pop());
+        }
+    }
+
+private:
+    static void refill(FreeList& freeList, int index)
+    {
+        auto pools = globalPools();
+        QMutexLocker locker(&pools->lock);
+
+        auto& globalList = pools->freeLists[size_t(index)];
+        if (globalList.count == 0)
+        {
+            const size_t blockSize = minBlockSize << index;
+            auto slab = static_cast<char*>(::operator new(blockSize * blocksBatch));
+            pools->slabs.push_back(slab);
+
+            for (int i = 0; i < blocksBatch; ++i)
+                freeList.push(reinterpret_cast<FreeBlock*>(slab + blockSize * size_t(i)));
+            return;
+        }
+
+        for (int i = 0; i < blocksBatch && globalList.count > 0; ++i)
+            freeList.push(globalList.pop());
+    }
+};
+
+} // end anonymous namespace
+
+AsyncMemoryResource* AsyncMemoryResource::threadDefault()
+{
+    return threadDefaultResource;
+}
+
+void AsyncMemoryResource::setThreadDefault(AsyncMemoryResource* resource)
+{
+    threadDefaultResource = resource;
+}
+
+AsyncMemoryResource* AsyncMemoryResource::threadPools()
+{
+    static AsyncThreadPoolsResource resource;
+    return &resource;
+}
+
+AsyncMonotonicResource::AsyncMonotonicResource(size_t initialChunkSize, AsyncMemoryResource* upstream)
+    : m_initialChunkSize(initialChunkSize),
+      m_upstream(upstream),
+      m_current(nullptr)
+{
+}
+
+AsyncMonotonicResource::~AsyncMonotonicResource()
+{
+    release();
+}
+
+void AsyncMonotonicResource::release()
+{
+    QMutexLocker locker(&m_chunksLock);
+
+    auto chunk = m_current.fetchAndStoreOrdered(nullptr);
+    while (chunk)
+    {
+        auto next = chunk->next;
+        upstreamDeallocate(m_upstream, chunk, sizeof(Chunk) + chunk->size, alignof(std::max_align_t));
+        chunk = next;
+    }
+}
+
+void* AsyncMonotonicResource::allocateImpl(size_t bytes, size_t alignment)
+{
+    // reserve enough space to align the block
+    const size_t reserve = bytes + alignment - 1;
+
+    for (;;)
+    {
+        auto chunk = m_current.loadAcquire();
+        if (chunk)
+        {
+            auto offset = chunk->offset.fetchAndAddOrdered(reserve);
+            if (offset + reserve <= chunk->size)
+            {
+                auto address = reinterpret_cast<quintptr>(chunk + 1) + offset;
+                address = (address + alignment - 1) & ~quintptr(alignment - 1);
+                return reinterpret_cast<void*>(address);
+            }
+        }
+
+        addChunk(chunk, reserve);
+    }
+}
+
+void AsyncMonotonicResource::deallocateImpl(void*, size_t, size_t)
+{
+    // memory is released by release()
+}
+
+AsyncMonotonicResource::Chunk* AsyncMonotonicResource::addChunk(Chunk* current, size_t minSize)
+{
+    QMutexLocker locker(&m_chunksLock);
+
+    // other thread has added chunk already
+    auto chunk = m_current.loadAcquire();
+    if (chunk != current)
+        return chunk;
+
+    // chunks grow geometrically
+    size_t size = chunk ? chunk->size * 2 : m_initialChunkSize;
+    while (size < minSize)
+        size *= 2;
+
+    auto memory = upstreamAllocate(m_upstream, sizeof(Chunk) + size, alignof(std::max_align_t));
+    chunk = new (memory) Chunk{current, size, {}};
+    m_current.storeRelease(chunk);
+
+    return chunk;
+}
@@ -0,0 +1,196 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_MEMORY_RESOURCE_H
+#define ASYNC_MEMORY_RESOURCE_H
+
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// source of memory for async values content and progress objects
+// (the same idea as std::pmr::memory_resource which is not available in C++14)
+class AsyncMemoryResource
+{
+public:
+    virtual ~AsyncMemoryResource() = default;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        return allocateImpl(bytes, alignment);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        deallocateImpl(p, bytes, alignment);
+    }
+
+    // resource used by values constructed in the current thread
+    // nullptr means global new/delete
+    static AsyncMemoryResource* threadDefault();
+    static void setThreadDefault(AsyncMemoryResource* resource);
+
+    // process-wide resource with per-thread pools of small blocks
+    static AsyncMemoryResource* threadPools();
+
+protected:
+    virtual void* allocateImpl(size_t bytes, size_t alignment) = 0;
+    virtual void deallocateImpl(void* p, size_t bytes, size_t alignment) = 0;
+};
+
+// sets thread default memory resource for the scope lifetime
+class AsyncMemoryResourceScope
+{
+    Q_DISABLE_COPY(AsyncMemoryResourceScope)
+
+public:
+    explicit AsyncMemoryResourceScope(AsyncMemoryResource* resource)
+        : m_previous(AsyncMemoryResource::threadDefault())
+    {
+        AsyncMemoryResource::setThreadDefault(resource);
+    }
+
+    ~AsyncMemoryResourceScope()
+    {
+        AsyncMemoryResource::setThreadDefault(m_previous);
+    }
+
+private:
+    AsyncMemoryResource* const m_previous;
+};
+
+// allocates from growing chunks, deallocate does nothing
+// all memory is released at once by release() or destructor
+// thread safe, so values built from the arena may be calculated in other threads
+class AsyncMonotonicResource : public AsyncMemoryResource
+{
+    Q_DISABLE_COPY(AsyncMonotonicResource)
+
+public:
+    explicit AsyncMonotonicResource(size_t initialChunkSize = 64 * 1024, AsyncMemoryResource* upstream = nullptr);
+    ~AsyncMonotonicResource() override;
+
+    // all objects allocated from the resource should be destroyed before
+    void release();
+
+protected:
+    void* allocateImpl(size_t bytes, size_t alignment) override;
+    void deallocateImpl(void* p, size_t bytes, size_t alignment) override;
+
+private:
+    struct Chunk
+    {
+        Chunk* next;
+        size_t size;
+        QAtomicInteger<size_t> offset;
+    };
+
+    Chunk* addChunk(Chunk* current, size_t minSize);
+
+    const size_t m_initialChunkSize;
+    AsyncMemoryResource* const m_upstream;
+
+    QMutex m_chunksLock;
+    QAtomicPointer<Chunk> m_current;
+};
+
+// deletes objects allocated from memory resource
+// default constructed or converted from std::default_delete deleter uses delete
+template <typename T>
+class AsyncDeleter
+{
+public:
+    AsyncDeleter() noexcept = default;
+
+    AsyncDeleter(AsyncMemoryResource* resource, size_t size, size_t alignment) noexcept
+        : m_resource(resource), m_size(size), m_alignment(alignment)
+    {
+    }
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+    AsyncDeleter(const std::default_delete<U>&) noexcept
+    {
+    }
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+    AsyncDeleter(const AsyncDeleter<U>& other) noexcept
+        : m_resource(other.resource()), m_size(other.size()), m_alignment(other.alignment())
+    {
+    }
+
+    AsyncMemoryResource* resource() const { return m_resource; }
+    size_t size() const { return m_size; }
+    size_t alignment() const { return m_alignment; }
+
+    void operator()(T* p) const
+    {
+        if (!m_resource)
+        {
+            delete p;
+            return;
+        }
+
+        // size of the most derived object is kept by deleter
+        p->~T();
+        m_resource->deallocate(const_cast<void*>(static_cast<const volatile void*>(p)), m_size, m_alignment);
+    }
+
+private:
+    AsyncMemoryResource* m_resource = nullptr;
+    size_t m_size = 0;
+    size_t m_alignment = 0;
+};
+
+template <typename T>
+using AsyncUniquePtr = std::unique_ptr<T, AsyncDeleter<T>>;
+
+// allocates object from the resource or by new if resource is nullptr
+template <typename T, typename... Args>
+AsyncUniquePtr<T> asyncMakeUnique(AsyncMemoryResource* resource, Args&& ...arguments)
+{
+    if (!resource)
+        return AsyncUniquePtr<T>(new T(std::forward<Args>(arguments)...));
+
+    void* memory = resource->allocate(sizeof(T), alignof(T));
+    try
+    {
+        return AsyncUniquePtr<T>(new (memory) T(std::forward<Args>(arguments)...), AsyncDeleter<T>(resource, sizeof(T), alignof(T)));
+    }
+    catch (...)
+    {
+        resource->deallocate(memory, sizeof(T), alignof(T));
+        throw;
+    }
+}
+
+// progresses created by asyncValueRunXXX functions are allocated from
+// the value memory resource or recycled by per-thread pools
+template <typename AsyncValueType, typename... ProgressArgs>
+AsyncUniquePtr<typename AsyncValueType::ProgressType> asyncMakeProgress(const AsyncValueType& value, ProgressArgs&& ...progressArgs)
+{
+    auto resource = value.memoryResource();
+    if (!resource)
+        resource = AsyncMemoryResource::threadPools();
+
+    return asyncMakeUnique<typename AsyncValueType::ProgressType>(resource, std::forward<ProgressArgs>(progressArgs)...);
+}
+
+#endif // ASYNC_MEMORY_RESOURCE_H
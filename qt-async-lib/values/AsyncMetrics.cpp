@@ -0,0 +1,330 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncMetrics.h"
+#include "AsyncValueBase.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#ifdef ASYNC_METRICS
+
+#include <QAtomicInteger>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <array>
+#include <memory>
+#include <vector>
+
+class AsyncMetricsPoolEntry
+{
+public:
+    QString name;
+    QAtomicInteger<qint64> queued;
+    QAtomicInteger<qint64> active;
+};
+
+namespace
+{
+
+enum COUNTER
+{
+    COUNTER_VALUES,
+    COUNTER_ERRORS,
+    COUNTER_PROGRESSES,
+    // per ASYNC_RUN_HELPER
+    COUNTER_RUNS_STARTED,
+    COUNTER_RUNS_BEGUN = COUNTER_RUNS_STARTED + ASYNC_RUN_HELPERS_COUNT,
+    COUNTER_RUNS_COMPLETED = COUNTER_RUNS_BEGUN + ASYNC_RUN_HELPERS_COUNT,
+    COUNTER_RUNS_STOPPED = COUNTER_RUNS_COMPLETED + ASYNC_RUN_HELPERS_COUNT,
+    COUNTER_RERUNS = COUNTER_RUNS_STOPPED + ASYNC_RUN_HELPERS_COUNT,
+    COUNTER_COUNT
+};
+
+// counters updated by one thread at a time
+// aligned to cache line to avoid false sharing between threads
+struct alignas(64) Shard
+{
+    std::array<QAtomicInteger<qint64>, COUNTER_COUNT> counters;
+};
+
+struct MetricsData
+{
+    QMutex lock;
+    // shards are never deleted, shard of finished thread is reused by a new thread
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<Shard*> freeShards;
+
+    std::vector<std::unique_ptr<AsyncMetricsPoolEntry>> pools;
+    QHash<QThreadPool*, AsyncMetricsPoolEntry*> poolsByPtr;
+};
+
+Q_GLOBAL_STATIC(MetricsData, metricsData)
+
+class ShardHandle
+{
+public:
+    ShardHandle()
+    {
+        auto data = metricsData();
+        QMutexLocker locker(&data->lock);
+
+        if (data->freeShards.empty())
+        {
+            data->shards.push_back(std::make_unique<Shard>());
+            shard = data->shards.back().get();
+        }
+        else
+        {
+            shard = data->freeShards.back();
+            data->freeShards.pop_back();
+        }
+    }
+
+    ~ShardHandle()
+    {
+        auto data = metricsData();
+        if (!data)
+            return;
+
+        QMutexLocker locker(&data->lock);
+        data->freeShards.push_back(shard);
+    }
+
+    Shard* shard = nullptr;
+};
+
+void add(int counter, qint64 delta)
+{
+    static thread_local ShardHandle handle;
+    handle.shard->counters[size_t(counter)].fetchAndAddRelaxed(delta);
+}
+
+int stateCounter(ASYNC_VALUE_STATE state)
+{
+    switch (state)
+    {
+    case ASYNC_VALUE_STATE::VALUE: return COUNTER_VALUES;
+    case ASYNC_VALUE_STATE::ERROR: return COUNTER_ERRORS;
+    case ASYNC_VALUE_STATE::PROGRESS: return COUNTER_PROGRESSES;
+    }
+
+    return COUNTER_VALUES;
+}
+
+int helperCounter(int counter, ASYNC_RUN_HELPER helper)
+{
+    return counter + static_cast<int>(helper);
+}
+
+std::array<qint64, COUNTER_COUNT> sumCounters()
+{
+    std::array<qint64, COUNTER_COUNT> result = {};
+
+    auto data = metricsData();
+    QMutexLocker locker(&data->lock);
+
+    for (const auto& shard : data->shards)
+    {
+        for (size_t i = 0; i < result.size(); ++i)
+            result[i] += shard->counters[i].loadAcquire();
+    }
+
+    return result;
+}
+
+} // end anonymous namespace
+
+bool AsyncMetrics::isEnabled()
+{
+    return true;
+}
+
+void AsyncMetrics::valueCreated(ASYNC_VALUE_STATE state)
+{
+    add(stateCounter(state), 1);
+}
+
+void AsyncMetrics::valueDestroyed(ASYNC_VALUE_STATE state)
+{
+    add(stateCounter(state), -1);
+}
+
+void AsyncMetrics::valueStateChanged(ASYNC_VALUE_STATE oldState, ASYNC_VALUE_STATE newState)
+{
+    if (oldState == newState)
+        return;
+
+    add(stateCounter(oldState), -1);
+    add(stateCounter(newState), 1);
+}
+
+void AsyncMetrics::runQueued(ASYNC_RUN_HELPER helper)
+{
+    add(helperCounter(COUNTER_RUNS_STARTED, helper), 1);
+}
+
+void AsyncMetrics::runStarted(ASYNC_RUN_HELPER helper)
+{
+    add(helperCounter(COUNTER_RUNS_BEGUN, helper), 1);
+}
+
+void AsyncMetrics::runFinished(ASYNC_RUN_HELPER helper, bool stopped)
+{
+    add(helperCounter(COUNTER_RUNS_COMPLETED, helper), 1);
+    if (stopped)
+        add(helperCounter(COUNTER_RUNS_STOPPED, helper), 1);
+}
+
+AsyncMetricsPoolEntry* AsyncMetrics::poolQueued(QThreadPool* pool)
+{
+    auto data = metricsData();
+    AsyncMetricsPoolEntry* entry = nullptr;
+    {
+        QMutexLocker locker(&data->lock);
+
+        // pools are identified by pointer, so a new pool allocated
+        // at the address of deleted one continues its statistics
+        entry = data->poolsByPtr.value(pool, nullptr);
+        if (!entry)
+        {
+            data->pools.push_back(std::make_unique<AsyncMetricsPoolEntry>());
+            entry = data->pools.back().get();
+            if (pool == QThreadPool::globalInstance())
+                entry->name = QStringLiteral("global");
+            else if (!pool->objectName().isEmpty())
+                entry->name = pool->objectName();
+            else
+                entry->name = QString("0x%1").arg(reinterpret_cast<quintptr>(pool), 0, 16);
+            data->poolsByPtr.insert(pool, entry);
+        }
+    }
+
+    entry->queued.fetchAndAddRelaxed(1);
+    return entry;
+}
+
+void AsyncMetrics::poolStarted(AsyncMetricsPoolEntry* pool)
+{
+    pool->queued.fetchAndAddRelaxed(-1);
+    pool->active.fetchAndAddRelaxed(1);
+}
+
+void AsyncMetrics::poolFinished(AsyncMetricsPoolEntry* pool)
+{
+    pool->active.fetchAndAddRelaxed(-1);
+}
+
+void AsyncMetrics::rerun()
+{
+    add(COUNTER_RERUNS, 1);
+}
+
+AsyncMetricsSnapshot AsyncMetrics::snapshot()
+{
+    AsyncMetricsSnapshot result;
+
+    auto counters = sumCounters();
+
+    result.values = counters[COUNTER_VALUES];
+    result.errors = counters[COUNTER_ERRORS];
+    result.progresses = counters[COUNTER_PROGRESSES];
+
+    for (int helper = 0; helper < ASYNC_RUN_HELPERS_COUNT; ++helper)
+    {
+        auto& runs = result.runs[helper];
+        auto begun = counters[size_t(COUNTER_RUNS_BEGUN + helper)];
+        runs.started = counters[size_t(COUNTER_RUNS_STARTED + helper)];
+        runs.completed = counters[size_t(COUNTER_RUNS_COMPLETED + helper)];
+        runs.stopped = counters[size_t(COUNTER_RUNS_STOPPED + helper)];
+        runs.queued = runs.started - begun;
+        runs.active = begun - runs.completed;
+    }
+
+    result.reruns = counters[COUNTER_RERUNS];
+
+    auto data = metricsData();
+    QMutexLocker locker(&data->lock);
+    for (const auto& entry : data->pools)
+    {
+        AsyncMetricsPool pool;
+        pool.name = entry->name;
+        pool.queued = entry->queued.loadAcquire();
+        pool.active = entry->active.loadAcquire();
+        result.pools.append(pool);
+    }
+
+    return result;
+}
+
+#else
+
+bool AsyncMetrics::isEnabled()
+{
+    return false;
+}
+
+AsyncMetricsSnapshot AsyncMetrics::snapshot()
+{
+    return AsyncMetricsSnapshot();
+}
+
+#endif // ASYNC_METRICS
+
+QByteArray AsyncMetrics::toJson()
+{
+    auto metrics = snapshot();
+
+    QJsonObject values;
+    values["value"] = metrics.values;
+    values["error"] = metrics.errors;
+    values["progress"] = metrics.progresses;
+
+    const char* helperNames[] = {"thread", "threadPool", "network", "future", "inline"};
+    QJsonObject runs;
+    for (int helper = 0; helper < ASYNC_RUN_HELPERS_COUNT; ++helper)
+    {
+        const auto& helperRuns = metrics.runs[helper];
+
+        QJsonObject object;
+        object["started"] = helperRuns.started;
+        object["completed"] = helperRuns.completed;
+        object["stopped"] = helperRuns.stopped;
+        object["queued"] = helperRuns.queued;
+        object["active"] = helperRuns.active;
+        runs[QString::fromLatin1(helperNames[helper])] = object;
+    }
+
+    QJsonArray pools;
+    for (const auto& pool : metrics.pools)
+    {
+        QJsonObject object;
+        object["name"] = pool.name;
+        object["queued"] = pool.queued;
+        object["active"] = pool.active;
+        pools.append(object);
+    }
+
+    QJsonObject root;
+    root["enabled"] = isEnabled();
+    root["values"] = values;
+    root["runs"] = runs;
+    root["pools"] = pools;
+    root["reruns"] = metrics.reruns;
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
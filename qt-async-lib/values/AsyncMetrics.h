@@ -0,0 +1,128 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_METRICS_H
+#define ASYNC_METRICS_H
+
+#include "../Config.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QThreadPool;
+enum class ASYNC_VALUE_STATE;
+
+enum class ASYNC_RUN_HELPER
+{
+    THREAD,         // asyncValueRunThread
+    THREAD_POOL,    // asyncValueRunThreadPool
+    NETWORK,        // asyncValueRunNetwork
+    FUTURE,         // asyncValueRunFuture and asyncValueRunStdFuture
+    INLINE          // asyncValueRunInline
+};
+
+const int ASYNC_RUN_HELPERS_COUNT = 5;
+
+struct AsyncMetricsRuns
+{
+    // progress was started
+    qint64 started = 0;
+    // calculation was completed
+    qint64 completed = 0;
+    // calculation was completed with stop request
+    qint64 stopped = 0;
+    // started but calculation hasn't begun yet
+    qint64 queued = 0;
+    // calculation is in progress
+    qint64 active = 0;
+};
+
+struct AsyncMetricsPool
+{
+    QString name;
+    qint64 queued = 0;
+    qint64 active = 0;
+};
+
+struct AsyncMetricsSnapshot
+{
+    // live async values by state
+    qint64 values = 0;
+    qint64 errors = 0;
+    qint64 progresses = 0;
+
+    // indexed by ASYNC_RUN_HELPER
+    AsyncMetricsRuns runs[ASYNC_RUN_HELPERS_COUNT];
+
+    QVector<AsyncMetricsPool> pools;
+
+    // reruns resolved by AsyncProgressRerun
+    qint64 reruns = 0;
+};
+
+class AsyncMetricsPoolEntry;
+
+// process-wide counters of async values and run helpers
+// counters are updated only if ASYNC_METRICS is defined (see Config.h)
+// each thread updates its own shard of counters so they don't contend
+class AsyncMetrics
+{
+public:
+    static bool isEnabled();
+
+    static AsyncMetricsSnapshot snapshot();
+    // returns snapshot in JSON format for monitoring agents
+    static QByteArray toJson();
+
+#ifdef ASYNC_METRICS
+    static void valueCreated(ASYNC_VALUE_STATE state);
+    static void valueDestroyed(ASYNC_VALUE_STATE state);
+    static void valueStateChanged(ASYNC_VALUE_STATE oldState, ASYNC_VALUE_STATE newState);
+
+    static void runQueued(ASYNC_RUN_HELPER helper);
+    static void runStarted(ASYNC_RUN_HELPER helper);
+    static void runFinished(ASYNC_RUN_HELPER helper, bool stopped);
+    template <typename ProgressType>
+    static void runFinished(ASYNC_RUN_HELPER helper, const ProgressType& progress)
+    {
+        runFinished(helper, progress.isStopRequested());
+    }
+
+    static AsyncMetricsPoolEntry* poolQueued(QThreadPool* pool);
+    static void poolStarted(AsyncMetricsPoolEntry* pool);
+    static void poolFinished(AsyncMetricsPoolEntry* pool);
+
+    static void rerun();
+#else
+    static void valueCreated(ASYNC_VALUE_STATE) {}
+    static void valueDestroyed(ASYNC_VALUE_STATE) {}
+    static void valueStateChanged(ASYNC_VALUE_STATE, ASYNC_VALUE_STATE) {}
+
+    static void runQueued(ASYNC_RUN_HELPER) {}
+    static void runStarted(ASYNC_RUN_HELPER) {}
+    static void runFinished(ASYNC_RUN_HELPER, bool) {}
+    template <typename ProgressType>
+    static void runFinished(ASYNC_RUN_HELPER, const ProgressType&) {}
+
+    static AsyncMetricsPoolEntry* poolQueued(QThreadPool*) { return nullptr; }
+    static void poolStarted(AsyncMetricsPoolEntry*) {}
+    static void poolFinished(AsyncMetricsPoolEntry*) {}
+
+    static void rerun() {}
+#endif
+};
+
+#endif // ASYNC_METRICS_H
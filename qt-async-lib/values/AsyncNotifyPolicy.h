@@ -0,0 +1,140 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_NOTIFY_POLICY_H
+#define ASYNC_NOTIFY_POLICY_H
+
+#include "AsyncValueBase.h"
+#include <type_traits>
+
+// policies select how async value delivers state changes
+// notifications are skipped (including emit guard and trace) if there are no listeners
+
+// notifies by AsyncValueBase::stateChanged signal
+// required by async widgets and item models
+struct AsyncNotifyPolicySignal
+{
+    template <typename AsyncValueType>
+    bool hasListeners(const AsyncValueType& value) const
+    {
+        return value.isStateChangedConnected();
+    }
+
+    template <typename AsyncValueType>
+    void notify(AsyncValueType& value, ASYNC_VALUE_STATE state) const
+    {
+        emit value.stateChanged(state);
+    }
+};
+
+// subscriber of AsyncNotifyPolicyCallbacks values
+// subscriber owns the callback and should unsubscribe it before destruction
+class AsyncStateCallback
+{
+    Q_DISABLE_COPY(AsyncStateCallback)
+    friend struct AsyncNotifyPolicyCallbacks;
+
+public:
+    using FnType = void(*)(void* context, ASYNC_VALUE_STATE state);
+
+    AsyncStateCallback(FnType fn, void* context)
+        : m_fn(fn), m_context(context)
+    {
+    }
+
+    ~AsyncStateCallback()
+    {
+        Q_ASSERT(!m_isSubscribed && "Callback should be unsubscribed before destruction");
+    }
+
+private:
+    FnType m_fn;
+    void* m_context;
+    AsyncStateCallback* m_prev = nullptr;
+    AsyncStateCallback* m_next = nullptr;
+    bool m_isSubscribed = false;
+};
+
+// notifies intrusive list of callbacks directly in the changing thread without meta-call
+// list is changed and walked under value write lock,
+// so callbacks shouldn't subscribe or unsubscribe
+struct AsyncNotifyPolicyCallbacks
+{
+    template <typename AsyncValueType>
+    bool hasListeners(const AsyncValueType&) const
+    {
+        return m_head != nullptr;
+    }
+
+    template <typename AsyncValueType>
+    void notify(AsyncValueType&, ASYNC_VALUE_STATE state) const
+    {
+        for (auto callback = m_head; callback; callback = callback->m_next)
+            callback->m_fn(callback->m_context, state);
+    }
+
+    void subscribe(AsyncStateCallback* callback)
+    {
+        Q_ASSERT(!callback->m_isSubscribed && "Callback is subscribed already");
+
+        callback->m_prev = nullptr;
+        callback->m_next = m_head;
+        if (m_head)
+            m_head->m_prev = callback;
+        m_head = callback;
+        callback->m_isSubscribed = true;
+    }
+
+    void unsubscribe(AsyncStateCallback* callback)
+    {
+        Q_ASSERT(callback->m_isSubscribed && "Callback is not subscribed");
+
+        if (callback->m_prev)
+            callback->m_prev->m_next = callback->m_next;
+        else
+            m_head = callback->m_next;
+        if (callback->m_next)
+            callback->m_next->m_prev = callback->m_prev;
+
+        callback->m_prev = nullptr;
+        callback->m_next = nullptr;
+        callback->m_isSubscribed = false;
+    }
+
+private:
+    AsyncStateCallback* m_head = nullptr;
+};
+
+// no notifications, for values used only by access and wait functions
+struct AsyncNotifyPolicyNone
+{
+    template <typename AsyncValueType>
+    bool hasListeners(const AsyncValueType&) const
+    {
+        return false;
+    }
+
+    template <typename AsyncValueType>
+    void notify(AsyncValueType&, ASYNC_VALUE_STATE) const {}
+};
+
+using AsyncNotifyPolicyDefault = AsyncNotifyPolicySignal;
+
+// detects async values that emit AsyncValueBase::stateChanged signal
+template <typename AsyncValueType>
+struct AsyncValueEmitsStateChanged : std::is_same<typename AsyncValueType::NotifyPolicy, AsyncNotifyPolicySignal> {};
+
+#endif // ASYNC_NOTIFY_POLICY_H
@@ -19,6 +19,9 @@
 
 #include <QObject>
 #include <QReadWriteLock>
+#include <QThread>
+#include "AsyncLockStats.h"
+#include "AsyncMetrics.h"
 
 enum class ASYNC_CAN_REQUEST_STOP
 {
@@ -43,27 +46,99 @@ public:
 #endif
     }
 
-    QString message() const { QReadLocker locker(&m_lock); return m_message; }
-    float progress() const { QReadLocker locker(&m_lock); return m_progress; }
-    bool canRequestStop() const { QReadLocker locker(&m_lock); return m_canRequestStop == ASYNC_CAN_REQUEST_STOP::YES; }
-    bool isStopRequested() const { QReadLocker locker(&m_lock); return m_isStopRequested; }
+    QString message() const { AsyncReadLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>()); return m_message; }
+    float progress() const { AsyncReadLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>()); return m_progress; }
+    bool canRequestStop() const { AsyncReadLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>()); return m_canRequestStop == ASYNC_CAN_REQUEST_STOP::YES; }
+    bool isStopRequested() const { AsyncReadLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>()); return m_isStopRequested; }
 
-    void setMessage(QString message) { QWriteLocker locker(&m_lock); m_message = std::move(message); }
-    void setProgress(float progress) { QWriteLocker locker(&m_lock); m_progress = progress; }
+    void setMessage(QString message) { AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>()); m_message = std::move(message); }
+    void setProgress(float progress)
+    {
+        ObserverType observer = nullptr;
+        const void* observerContext = nullptr;
+        {
+            AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>());
+            m_progress = progress;
+            observer = m_observer;
+            observerContext = m_observerContext;
+        }
+
+        if (observer)
+            observer(observerContext, progress);
+    }
     template <typename Num>
     void setProgress(Num current, Num total)
     {
         if (total != 0)
             setProgress(static_cast<float>(current) / static_cast<float>(total));
     }
-    void requestStop() { QWriteLocker locker(&m_lock); m_isStopRequested = true; }
+    void requestStop() { AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>()); m_isStopRequested = true; }
+
+    // observer is called on every progress position change
+    // it's used to trace async values
+    using ObserverType = void (*)(const void* context, float progress);
+    void setObserver(ObserverType observer, const void* context)
+    {
+        AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>());
+        m_observer = observer;
+        m_observerContext = context;
+    }
+
+    // changes priority of the thread executing the progress
+    // QThread::InheritPriority restores original priority of the thread
+    void setThreadPriority(QThread::Priority priority)
+    {
+        AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>());
+        m_threadPriority = priority;
+        applyThreadPriority();
+    }
+
+    // asyncValueRunXXX functions attach executing thread at the calculation start
+    // and detach it at the calculation end
+    void attachThread(QThread* thread)
+    {
+        AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>());
+        Q_ASSERT(!m_thread && "Progress thread is attached already");
+        m_thread = thread;
+        m_threadOriginalPriority = m_thread->priority();
+        applyThreadPriority();
+    }
+
+    void detachThread()
+    {
+        AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>());
+        if (!m_thread)
+            return;
+
+        if (m_threadPriority != QThread::InheritPriority)
+            m_thread->setPriority(originalThreadPriority());
+        m_thread = nullptr;
+    }
 
 #ifdef QT_DEBUG
-    bool isInUse() const { QReadLocker locker(&m_lock); return m_isInUse; }
-    void setInUse(bool inUse) { QWriteLocker locker(&m_lock); m_isInUse = inUse; }
+    bool isInUse() const { AsyncReadLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>()); return m_isInUse; }
+    void setInUse(bool inUse) { AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>()); m_isInUse = inUse; }
 #endif
 
 protected:
+    // should be called under m_lock
+    void applyThreadPriority()
+    {
+        if (!m_thread)
+            return;
+
+        if (m_threadPriority == QThread::InheritPriority)
+            m_thread->setPriority(originalThreadPriority());
+        else
+            m_thread->setPriority(m_threadPriority);
+    }
+
+    QThread::Priority originalThreadPriority() const
+    {
+        // cannot assign InheritPriority to running thread
+        return (m_threadOriginalPriority == QThread::InheritPriority) ? QThread::NormalPriority : m_threadOriginalPriority;
+    }
+
     mutable QReadWriteLock m_lock;
 
     QString m_message;
@@ -71,6 +146,13 @@ protected:
     ASYNC_CAN_REQUEST_STOP m_canRequestStop = ASYNC_CAN_REQUEST_STOP::YES;
     bool m_isStopRequested = false;
 
+    ObserverType m_observer = nullptr;
+    const void* m_observerContext = nullptr;
+
+    QThread* m_thread = nullptr;
+    QThread::Priority m_threadPriority = QThread::InheritPriority;
+    QThread::Priority m_threadOriginalPriority = QThread::InheritPriority;
+
 #ifdef QT_DEBUG
     bool m_isInUse = false;
 #endif
@@ -90,33 +172,46 @@ public:
 
     bool isRerunRequested() const
     {
-        QReadLocker locker(&m_lock);
+        AsyncReadLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>());
         return m_isRerunRequested;
     }
 
-    void requestRerun()
+    // returns false if calculation has made its last pass already
+    // and cannot see the request anymore
+    bool requestRerun()
     {
-        QWriteLocker locker(&m_lock);
+        AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>());
+
+        if (m_isRerunClosed)
+            return false;
 
         m_isRerunRequested = true;
         m_isStopRequested = true;
+        return true;
     }
 
+    // if no rerun was requested rejects all further requests
     bool resetIfRerunRequested()
     {
-        QWriteLocker locker(&m_lock);
+        AsyncWriteLocker locker(&m_lock, asyncLockStats<AsyncProgress, ASYNC_LOCK::PROGRESS>());
 
         if (!m_isRerunRequested)
+        {
+            m_isRerunClosed = true;
             return false;
+        }
 
         m_isStopRequested = false;
         m_isRerunRequested = false;
 
+        AsyncMetrics::rerun();
+
         return true;
     }
 
 protected:
     bool m_isRerunRequested = false;
+    bool m_isRerunClosed = false;
 };
 
 #endif // ASYNC_PROGRESS_H
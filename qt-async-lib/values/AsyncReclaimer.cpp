@@ -0,0 +1,44 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncReclaimer.h"
+
+AsyncReclaimer::AsyncReclaimer(qint64 maxPendingBytes, qint64 minBytes)
+    : m_maxPendingBytes(maxPendingBytes),
+      m_minBytes(minBytes),
+      m_pendingBytes(0),
+      m_reclaimedCount(0),
+      m_overflowCount(0)
+{
+    m_worker.setMaxThreadCount(1);
+}
+
+AsyncReclaimer::~AsyncReclaimer()
+{
+    flush();
+}
+
+AsyncReclaimer* AsyncReclaimer::global()
+{
+    // never destroyed, so values may outlive static objects
+    static auto reclaimer = new AsyncReclaimer();
+    return reclaimer;
+}
+
+void AsyncReclaimer::flush()
+{
+    m_worker.waitForDone();
+}
@@ -0,0 +1,95 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_RECLAIMER_H
+#define ASYNC_RECLAIMER_H
+
+#include <QAtomicInteger>
+#include <QThreadPool>
+#include "AsyncRunnable.h"
+#include "../Config.h"
+
+// destroys objects replaced in async values by a background thread
+// so destruction of big values doesn't delay producers and waiters
+// objects smaller than minBytes are destroyed by the caller because it's cheaper
+// if pending objects exceed maxPendingBytes the caller destroys them too (backpressure)
+// note: QPixmap and other GUI objects should be destroyed in GUI thread, don't reclaim them
+class AsyncReclaimer
+{
+    Q_DISABLE_COPY(AsyncReclaimer)
+
+public:
+    explicit AsyncReclaimer(qint64 maxPendingBytes = ASYNC_RECLAIMER_MAX_PENDING_BYTES, qint64 minBytes = ASYNC_RECLAIMER_MIN_BYTES);
+    // waits for pending objects
+    ~AsyncReclaimer();
+
+    // reclaimer shared by all values
+    static AsyncReclaimer* global();
+
+    qint64 maxPendingBytes() const { return m_maxPendingBytes.loadAcquire(); }
+    void setMaxPendingBytes(qint64 bytes) { m_maxPendingBytes.storeRelease(bytes); }
+
+    qint64 minBytes() const { return m_minBytes.loadAcquire(); }
+    void setMinBytes(qint64 bytes) { m_minBytes.storeRelease(bytes); }
+
+    // approximate size of objects waiting for destruction
+    qint64 pendingBytes() const { return m_pendingBytes.loadAcquire(); }
+    // number of objects destroyed in background
+    quint64 reclaimedCount() const { return m_reclaimedCount.loadAcquire(); }
+    // number of big objects destroyed by caller because of full backlog
+    quint64 overflowCount() const { return m_overflowCount.loadAcquire(); }
+
+    // takes ownership of the object and destroys it later
+    template <typename T>
+    void retire(T object, qint64 bytes)
+    {
+        if (bytes < minBytes())
+            return;
+
+        if (m_pendingBytes.fetchAndAddOrdered(bytes) + bytes > maxPendingBytes())
+        {
+            m_pendingBytes.fetchAndAddOrdered(-bytes);
+            m_overflowCount.fetchAndAddRelaxed(1);
+            return;
+        }
+
+        AsyncRunnable::start(&m_worker, [this, bytes, object = std::move(object)]() mutable {
+            {
+                T retired = std::move(object);
+            }
+            m_pendingBytes.fetchAndAddOrdered(-bytes);
+            m_reclaimedCount.fetchAndAddRelaxed(1);
+        }, [](auto& reclaim) {
+            // dropped by the pool, destroy the object right away
+            reclaim();
+        });
+    }
+
+    // waits until all pending objects are destroyed
+    void flush();
+
+private:
+    QAtomicInteger<qint64> m_maxPendingBytes;
+    QAtomicInteger<qint64> m_minBytes;
+    QAtomicInteger<qint64> m_pendingBytes;
+    QAtomicInteger<quint64> m_reclaimedCount;
+    QAtomicInteger<quint64> m_overflowCount;
+
+    // single thread keeps destruction off CPUs used by calculations
+    QThreadPool m_worker;
+};
+
+#endif // ASYNC_RECLAIMER_H
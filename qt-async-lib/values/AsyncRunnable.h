@@ -0,0 +1,147 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_RUNNABLE_H
+#define ASYNC_RUNNABLE_H
+
+#include <QRunnable>
+#include <QThreadPool>
+#include <type_traits>
+#include "AsyncMemoryResource.h"
+
+// inline storage size of AsyncRunnable closures
+#define ASYNC_RUNNABLE_INLINE_SIZE 128
+
+// default discard function of AsyncRunnable, drops the closure
+struct AsyncRunnableNoDiscard
+{
+    template <typename Func>
+    void operator()(Func&) const {}
+};
+
+// QRunnable with move-only closure stored inline
+// runnables are allocated from per-thread pools and recycled when QThreadPool deletes them (autoDelete)
+// runnable deleted without run (by QThreadPool::clear or after QThreadPool::tryTake)
+// calls discard(func) in the deleting thread, so the closure can release what it holds
+// exceptions of func are not caught, as for any QRunnable
+class AsyncRunnable final : public QRunnable
+{
+    Q_DISABLE_COPY(AsyncRunnable)
+
+public:
+    template <typename Func, typename DiscardFunc = AsyncRunnableNoDiscard>
+    static AsyncRunnable* create(Func&& func, DiscardFunc&& discard = DiscardFunc())
+    {
+        auto runnable = new AsyncRunnable();
+        runnable->emplace(std::forward<Func>(func), std::forward<DiscardFunc>(discard));
+        return runnable;
+    }
+
+    template <typename Func, typename DiscardFunc = AsyncRunnableNoDiscard>
+    static void start(QThreadPool* pool, Func&& func, DiscardFunc&& discard = DiscardFunc())
+    {
+        pool->start(create(std::forward<Func>(func), std::forward<DiscardFunc>(discard)));
+    }
+
+    void run() override
+    {
+        m_isRun = true;
+        m_invoke(m_storage);
+    }
+
+    static void* operator new(size_t bytes)
+    {
+        return AsyncMemoryResource::threadPools()->allocate(bytes, alignof(AsyncRunnable));
+    }
+
+    static void operator delete(void* p, size_t bytes)
+    {
+        AsyncMemoryResource::threadPools()->deallocate(p, bytes, alignof(AsyncRunnable));
+    }
+
+    ~AsyncRunnable() override
+    {
+        if (!m_isRun)
+            m_discard(m_storage);
+        m_destroy(m_storage);
+    }
+
+private:
+    AsyncRunnable() = default;
+
+    template <typename Func, typename DiscardFunc>
+    struct Closure
+    {
+        std::decay_t<Func> func;
+        std::decay_t<DiscardFunc> discard;
+    };
+
+    template <typename ClosureType>
+    using IsInline = std::integral_constant<bool, sizeof(ClosureType) <= ASYNC_RUNNABLE_INLINE_SIZE
+                                                  && alignof(ClosureType) <= alignof(std::max_align_t)>;
+
+    template <typename Func, typename DiscardFunc>
+    void emplace(Func&& func, DiscardFunc&& discard)
+    {
+        using ClosureType = Closure<Func, DiscardFunc>;
+        emplace<ClosureType>(std::forward<Func>(func), std::forward<DiscardFunc>(discard), IsInline<ClosureType>());
+    }
+
+    template <typename ClosureType, typename Func, typename DiscardFunc>
+    void emplace(Func&& func, DiscardFunc&& discard, std::true_type /*inline*/)
+    {
+        new (m_storage) ClosureType{std::forward<Func>(func), std::forward<DiscardFunc>(discard)};
+        m_invoke = [](void* storage) {
+            auto closure = static_cast<ClosureType*>(storage);
+            closure->func();
+        };
+        m_discard = [](void* storage) {
+            auto closure = static_cast<ClosureType*>(storage);
+            closure->discard(closure->func);
+        };
+        m_destroy = [](void* storage) {
+            static_cast<ClosureType*>(storage)->~ClosureType();
+        };
+    }
+
+    template <typename ClosureType, typename Func, typename DiscardFunc>
+    void emplace(Func&& func, DiscardFunc&& discard, std::false_type /*inline*/)
+    {
+        // big closures are kept on heap
+        *reinterpret_cast<ClosureType**>(m_storage) = new ClosureType{std::forward<Func>(func), std::forward<DiscardFunc>(discard)};
+        m_invoke = [](void* storage) {
+            auto closure = *static_cast<ClosureType**>(storage);
+            closure->func();
+        };
+        m_discard = [](void* storage) {
+            auto closure = *static_cast<ClosureType**>(storage);
+            closure->discard(closure->func);
+        };
+        m_destroy = [](void* storage) {
+            delete *static_cast<ClosureType**>(storage);
+        };
+    }
+
+    using StorageFn = void(*)(void*);
+
+    StorageFn m_invoke = nullptr;
+    StorageFn m_discard = nullptr;
+    StorageFn m_destroy = nullptr;
+    bool m_isRun = false;
+    alignas(std::max_align_t) unsigned char m_storage[ASYNC_RUNNABLE_INLINE_SIZE];
+};
+
+#endif // ASYNC_RUNNABLE_H
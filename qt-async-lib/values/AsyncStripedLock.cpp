@@ -0,0 +1,26 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncStripedLock.h"
+
+AsyncStripedLock::Stripe& AsyncStripedLock::stripe(const void* address)
+{
+    static Stripe stripes[stripesCount()];
+
+    // fibonacci hashing of the address without low bits that are equal due to alignment
+    auto hash = static_cast<quint32>(reinterpret_cast<quintptr>(address) >> 4) * 2654435769u;
+    return stripes[hash >> (32 - ASYNC_STRIPED_LOCK_BITS)];
+}
@@ -0,0 +1,45 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_STRIPED_LOCK_H
+#define ASYNC_STRIPED_LOCK_H
+
+#include "../Config.h"
+#include <QMutex>
+#include <QWaitCondition>
+
+// process-wide table of mutexes and wait conditions shared by many objects
+// object is mapped to a stripe by its address, so objects don't need own locks
+// stripe is shared with unrelated objects: never run user code while holding it
+// and expect spurious wakeups
+class AsyncStripedLock
+{
+public:
+    struct alignas(64) Stripe
+    {
+        QMutex mutex;
+        QWaitCondition condition;
+    };
+
+    static Stripe& stripe(const void* address);
+
+    static constexpr int stripesCount()
+    {
+        return 1 << ASYNC_STRIPED_LOCK_BITS;
+    }
+};
+
+#endif // ASYNC_STRIPED_LOCK_H
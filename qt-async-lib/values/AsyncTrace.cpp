@@ -0,0 +1,228 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncTrace.h"
+#include "../Config.h"
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QVector>
+
+namespace
+{
+
+struct TraceEvent
+{
+    ASYNC_TRACE_EVENT event;
+    int thread;
+    quintptr value;
+    qint64 timestamp;
+    float progress;
+};
+
+struct TraceData
+{
+    TraceData()
+    {
+        clock.start();
+    }
+
+    QMutex lock;
+    QVector<TraceEvent> events;
+    qint64 droppedEvents = 0;
+    QElapsedTimer clock;
+};
+
+Q_GLOBAL_STATIC(TraceData, traceData)
+
+QAtomicInt traceEnabled(1);
+QAtomicInt nextThreadId(0);
+
+// small sequential thread ids are easier to read in trace viewers
+int currentThreadId()
+{
+    static thread_local int threadId = nextThreadId.fetchAndAddRelaxed(1) + 1;
+    return threadId;
+}
+
+const char* eventName(ASYNC_TRACE_EVENT event)
+{
+    switch (event)
+    {
+    case ASYNC_TRACE_EVENT::QUEUED: return "queued";
+    case ASYNC_TRACE_EVENT::STARTED: return "started";
+    case ASYNC_TRACE_EVENT::PROGRESS: return "progress";
+    case ASYNC_TRACE_EVENT::VALUE: return "value";
+    case ASYNC_TRACE_EVENT::ERROR: return "error";
+    case ASYNC_TRACE_EVENT::COMPLETED: return "completed";
+    case ASYNC_TRACE_EVENT::NOTIFIED: return "notified";
+    }
+
+    return "unknown";
+}
+
+QJsonObject makeEvent(const TraceEvent& event, const char* name, const char* phase, qint64 pid)
+{
+    QJsonObject object;
+    object["name"] = QString::fromLatin1(name);
+    object["cat"] = QString::fromLatin1("async");
+    object["ph"] = QString::fromLatin1(phase);
+    // timestamps are in microseconds
+    object["ts"] = static_cast<double>(event.timestamp) / 1000.;
+    object["pid"] = pid;
+    object["tid"] = event.thread;
+    return object;
+}
+
+}
+
+bool AsyncTrace::isEnabled()
+{
+    return traceEnabled.loadAcquire() != 0;
+}
+
+void AsyncTrace::setEnabled(bool enabled)
+{
+    traceEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+void AsyncTrace::record(ASYNC_TRACE_EVENT event, const void* value, float progress)
+{
+    if (!isEnabled())
+        return;
+
+    auto data = traceData();
+    TraceEvent traceEvent{event, currentThreadId(), reinterpret_cast<quintptr>(value), 0, progress};
+
+    QMutexLocker locker(&data->lock);
+
+    if (data->events.size() >= ASYNC_TRACE_MAX_EVENTS)
+    {
+        ++data->droppedEvents;
+        return;
+    }
+
+    traceEvent.timestamp = data->clock.nsecsElapsed();
+    data->events.append(traceEvent);
+}
+
+void AsyncTrace::clear()
+{
+    auto data = traceData();
+    QMutexLocker locker(&data->lock);
+    data->events.clear();
+    data->droppedEvents = 0;
+}
+
+QByteArray AsyncTrace::toChromeTraceJson()
+{
+    QVector<TraceEvent> events;
+    qint64 droppedEvents = 0;
+    {
+        auto data = traceData();
+        QMutexLocker locker(&data->lock);
+        events = data->events;
+        droppedEvents = data->droppedEvents;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    // open "queued" or "running" span for every async value
+    enum class SPAN { NONE, QUEUED, RUNNING };
+    QHash<quintptr, SPAN> spans;
+
+    QJsonArray traceEvents;
+
+    auto beginSpan = [&traceEvents, pid](const TraceEvent& event, const char* name) {
+        auto object = makeEvent(event, name, "b", pid);
+        object["id"] = QString::number(event.value, 16);
+        traceEvents.append(object);
+    };
+
+    auto endSpan = [&traceEvents, pid](const TraceEvent& event, const char* name) {
+        auto object = makeEvent(event, name, "e", pid);
+        object["id"] = QString::number(event.value, 16);
+        traceEvents.append(object);
+    };
+
+    for (const auto& event : events)
+    {
+        auto& span = spans[event.value];
+
+        switch (event.event)
+        {
+        case ASYNC_TRACE_EVENT::QUEUED:
+            beginSpan(event, "queued");
+            span = SPAN::QUEUED;
+            break;
+
+        case ASYNC_TRACE_EVENT::STARTED:
+            if (span == SPAN::QUEUED)
+                endSpan(event, "queued");
+            beginSpan(event, "running");
+            span = SPAN::RUNNING;
+            break;
+
+        case ASYNC_TRACE_EVENT::COMPLETED:
+            if (span == SPAN::QUEUED)
+                endSpan(event, "queued");
+            else if (span == SPAN::RUNNING)
+                endSpan(event, "running");
+            span = SPAN::NONE;
+            break;
+
+        default:
+            break;
+        }
+
+        // every event is visible as an instant event on its thread
+        auto object = makeEvent(event, eventName(event.event), "i", pid);
+        object["s"] = QString::fromLatin1("t");
+
+        QJsonObject args;
+        args["value"] = QString::number(event.value, 16);
+        if (event.event == ASYNC_TRACE_EVENT::PROGRESS)
+            args["progress"] = event.progress;
+        object["args"] = args;
+
+        traceEvents.append(object);
+    }
+
+    QJsonObject metadata;
+    metadata["droppedEvents"] = droppedEvents;
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = QString::fromLatin1("ms");
+    root["metadata"] = metadata;
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool AsyncTrace::exportChromeTrace(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    return file.write(toChromeTraceJson()) >= 0;
+}
@@ -0,0 +1,57 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_TRACE_H
+#define ASYNC_TRACE_H
+
+#include <QByteArray>
+#include <QString>
+
+enum class ASYNC_TRACE_EVENT
+{
+    // progress started, calculation is scheduled
+    QUEUED,
+    // calculation started in executing thread
+    STARTED,
+    // progress position changed
+    PROGRESS,
+    // value assigned
+    VALUE,
+    // error assigned
+    ERROR,
+    // progress completed
+    COMPLETED,
+    // stateChanged signal emitted
+    NOTIFIED
+};
+
+// process-wide recorder of async values lifecycle events
+// events are recorded by AsyncTracePolicyChrome
+class AsyncTrace
+{
+public:
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    static void record(ASYNC_TRACE_EVENT event, const void* value, float progress = 0.f);
+    static void clear();
+
+    // returns recorded events in Chrome/Perfetto trace event JSON format
+    static QByteArray toChromeTraceJson();
+    static bool exportChromeTrace(const QString& filePath);
+};
+
+#endif // ASYNC_TRACE_H
@@ -0,0 +1,59 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_TRACE_POLICY_H
+#define ASYNC_TRACE_POLICY_H
+
+#include "AsyncTrace.h"
+
+struct AsyncTracePolicyNone
+{
+    template <typename ProgressType>
+    void queued(const void* /*value*/, ProgressType& /*progress*/) const {}
+    void started(const void* /*value*/) const {}
+    void value(const void* /*value*/) const {}
+    void error(const void* /*value*/) const {}
+    void completed(const void* /*value*/) const {}
+    void notified(const void* /*value*/) const {}
+};
+
+// records lifecycle of async values into AsyncTrace
+struct AsyncTracePolicyChrome
+{
+    template <typename ProgressType>
+    void queued(const void* value, ProgressType& progress) const
+    {
+        AsyncTrace::record(ASYNC_TRACE_EVENT::QUEUED, value);
+        progress.setObserver([](const void* value, float progress) {
+            AsyncTrace::record(ASYNC_TRACE_EVENT::PROGRESS, value, progress);
+        }, value);
+    }
+
+    void started(const void* value) const { AsyncTrace::record(ASYNC_TRACE_EVENT::STARTED, value); }
+    void value(const void* value) const { AsyncTrace::record(ASYNC_TRACE_EVENT::VALUE, value); }
+    void error(const void* value) const { AsyncTrace::record(ASYNC_TRACE_EVENT::ERROR, value); }
+    void completed(const void* value) const { AsyncTrace::record(ASYNC_TRACE_EVENT::COMPLETED, value); }
+    void notified(const void* value) const { AsyncTrace::record(ASYNC_TRACE_EVENT::NOTIFIED, value); }
+};
+
+// define ASYNC_TRACE to trace all async values with default policies
+#ifdef ASYNC_TRACE
+using AsyncTracePolicyDefault = AsyncTracePolicyChrome;
+#else
+using AsyncTracePolicyDefault = AsyncTracePolicyNone;
+#endif
+
+#endif // ASYNC_TRACE_POLICY_H
@@ -18,6 +18,7 @@
 #define ASYNC_TRACK_ERRORS_POLICY_H
 
 #include <QThread>
+#include <QAtomicPointer>
 #include <stdexcept>
 
 struct AsyncTrackErrorsPolicyNone
@@ -34,6 +35,7 @@ struct AsyncTrackErrorsPolicyNone
     void startProgressWhileInProgress() const {}
     void tryCompleteAlienProgress() const {}
     void incompleteProgress() const {}
+    void reclaimerWithMemoryResource() const {}
 };
 
 struct AsyncTrackErrorsPolicyDefault
@@ -43,15 +45,15 @@ struct AsyncTrackErrorsPolicyDefault
         EmitGuard(AsyncTrackErrorsPolicyDefault& owner)
             : m_owner(owner)
         {
-            Q_ASSERT(!m_owner.m_emitThread && "Cannot emit while emitting");
+            Q_ASSERT(!m_owner.m_emitThread.loadAcquire() && "Cannot emit while emitting");
             // save emitting thread
-            m_owner.m_emitThread = QThread::currentThread();
+            m_owner.m_emitThread.storeRelease(QThread::currentThread());
         }
 
         ~EmitGuard()
         {
             // reset emitting thread
-            m_owner.m_emitThread = nullptr;
+            m_owner.m_emitThread.storeRelease(nullptr);
          }
 
     private:
@@ -61,7 +63,8 @@ struct AsyncTrackErrorsPolicyDefault
     using EmitGuardType = EmitGuard;
     void trackEmitDeadlock() const
     {
-        if (m_emitThread == QThread::currentThread())
+        // m_emitThread is written under write lock but read by any thread
+        if (m_emitThread.loadAcquire() == QThread::currentThread())
             throw std::logic_error("Async value deadlock");
     }
 
@@ -85,8 +88,13 @@ struct AsyncTrackErrorsPolicyDefault
         throw std::logic_error("Neither value no error was assigned at the progress stop");
     }
 
+    void reclaimerWithMemoryResource() const
+    {
+        Q_ASSERT(false && "Content allocated from memory resource cannot be handed to reclaimer");
+    }
+
 private:
-    QThread* m_emitThread = nullptr;
+    QAtomicPointer<QThread> m_emitThread;
 };
 
 #endif // ASYNC_TRACK_ERRORS_POLICY_H
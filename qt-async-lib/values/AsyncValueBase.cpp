@@ -15,7 +15,9 @@
 */
 
 #include "AsyncValueBase.h"
+#include "AsyncStripedLock.h"
 #include <QMetaType>
+#include <QMetaMethod>
 
 static auto async_value_state_type_id = qRegisterMetaType<ASYNC_VALUE_STATE>("ASYNC_VALUE_STATE");
 
@@ -23,7 +25,71 @@ AsyncValueBase::AsyncValueBase(ASYNC_VALUE_STATE state, QObject* parent)
     : QObject(parent),
       m_writeLock(QMutex::NonRecursive),
       m_contentLock(QReadWriteLock::NonRecursive),
-      m_state(state)
+      m_state(state),
+      m_waitState(static_cast<int>(state))
 {
+    AsyncMetrics::valueCreated(m_state);
 }
 
+AsyncValueBase::~AsyncValueBase()
+{
+    AsyncMetrics::valueDestroyed(m_state);
+}
+
+bool AsyncValueBase::isStateChangedConnected() const
+{
+    static const auto stateChangedSignal = QMetaMethod::fromSignal(&AsyncValueBase::stateChanged);
+    return isSignalConnected(stateChangedSignal);
+}
+
+void AsyncValueBase::endPublish()
+{
+    auto& stripe = AsyncStripedLock::stripe(this);
+    QMutexLocker locker(&stripe.mutex);
+
+    for (auto waiter = m_waiters; waiter; waiter = waiter->next)
+        waiter->condition.wakeOne();
+
+    m_publisher.testAndSetRelease(QThread::currentThread(), nullptr);
+
+    // woken waiters need the stripe mutex to return, fast path waiters wait for zero,
+    // so nothing touches the value after this line
+    m_publishers.fetchAndAddRelease(-1);
+}
+
+void AsyncValueBase::waitSlow(bool untilNoProgress)
+{
+    auto& stripe = AsyncStripedLock::stripe(this);
+    QMutexLocker locker(&stripe.mutex);
+
+    Waiter waiter;
+    waiter.next = m_waiters;
+    if (m_waiters)
+        m_waiters->prev = &waiter;
+    m_waiters = &waiter;
+    m_waitersCount.fetchAndAddRelease(1);
+    SCOPE_EXIT {
+        m_waitersCount.fetchAndAddRelease(-1);
+        if (waiter.prev)
+            waiter.prev->next = waiter.next;
+        else
+            m_waiters = waiter.next;
+        if (waiter.next)
+            waiter.next->prev = waiter.prev;
+    };
+
+    for (;;)
+    {
+        // stripe is shared with other values, never wait for value locks under it
+        if (untilNoProgress)
+        {
+            if (m_waitState.loadAcquire() != static_cast<int>(ASYNC_VALUE_STATE::PROGRESS))
+                return;
+        }
+        // endPublish decrements under the stripe mutex
+        else if (m_publishers.loadAcquire() == 0)
+            return;
+
+        waiter.condition.wait(&stripe.mutex);
+    }
+}
@@ -19,7 +19,9 @@
 
 #include "../Config.h"
 #include "../third_party/scope_exit.h"
+#include "AsyncMetrics.h"
 #include <QObject>
+#include <QAtomicInteger>
 #include <QMutex>
 #include <QReadWriteLock>
 #include <QWaitCondition>
@@ -38,24 +40,99 @@ class AsyncValueBase : public QObject
     Q_OBJECT
     Q_DISABLE_COPY(AsyncValueBase)
 
+public:
+    // number of value, error and progress changes, can be read without locks
+    quint64 version() const
+    {
+        return m_version.loadAcquire();
+    }
+
+    // true if stateChanged signal has connected slots
+    bool isStateChangedConnected() const;
+
+    // number of threads sleeping in wait(), for diagnostics and benchmarks
+    int waitersCount() const
+    {
+        return m_waitersCount.loadAcquire();
+    }
+
 signals:
     void stateChanged(ASYNC_VALUE_STATE state);
 
 protected:
     explicit AsyncValueBase(ASYNC_VALUE_STATE state, QObject* parent = nullptr);
+    ~AsyncValueBase() override;
+
+    // should be called under m_contentLock
+    void setState(ASYNC_VALUE_STATE state)
+    {
+        AsyncMetrics::valueStateChanged(m_state, state);
+        m_state = state;
+        m_waitState.storeRelease(static_cast<int>(state));
+    }
+
+    // should be called under m_contentLock
+    void incrementVersion()
+    {
+        m_version.fetchAndAddRelease(1);
+    }
+
+    // should be called under m_contentLock before the value leaves progress state,
+    // wait() doesn't return until the matching endPublish
+    void beginPublish()
+    {
+        m_publishers.fetchAndAddRelaxed(1);
+        m_publisher.storeRelease(QThread::currentThread());
+    }
+
+    // wakes threads blocked in waitNoProgress and waitPublished
+    // should be called after m_writeLock is released, it is the last access to the value:
+    // a waiter may destroy the value as soon as it returns
+    void endPublish();
+
+    // blocks until the value leaves progress state
+    // should be called without locks
+    void waitNoProgress()
+    {
+        waitSlow(true);
+    }
+
+    // blocks until producers which changed the state have left the value
+    // should be called without locks
+    void waitPublished()
+    {
+        // a slot called from stateChanged waits on the producer thread
+        if (m_publishers.loadAcquire() == 0 || m_publisher.loadAcquire() == QThread::currentThread())
+            return;
+
+        waitSlow(false);
+    }
 
     QMutex m_writeLock;
     QReadWriteLock m_contentLock;
     ASYNC_VALUE_STATE m_state;
+    QAtomicInteger<quint64> m_version;
 
+private:
+    // waiter sleeps on own condition, so producer wakes only waiters of this value
     struct Waiter
     {
-        QWaitCondition waitValue;
-
-        quint16 subWaiters = 0;
-        QWaitCondition waitSubWaiters;
+        QWaitCondition condition;
+        Waiter* prev = nullptr;
+        Waiter* next = nullptr;
     };
-    Waiter* m_waiter = nullptr;
+
+    void waitSlow(bool untilNoProgress);
+
+    // number of producers between beginPublish and endPublish
+    QAtomicInt m_publishers;
+    // thread of the last producer, cleared by its endPublish
+    QAtomicPointer<QThread> m_publisher;
+    // copy of m_state for waiters, they cannot take m_contentLock under the stripe mutex
+    QAtomicInt m_waitState;
+    // guarded by the stripe mutex
+    Waiter* m_waiters = nullptr;
+    QAtomicInt m_waitersCount;
 };
 
 #endif // ASYNC_VALUE_BASE_H
@@ -0,0 +1,227 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncValueCompactBase.h"
+#include "AsyncStripedLock.h"
+
+// how many times lock is tried before sleeping on the stripe
+static const int spinCount = 64;
+
+static QAtomicInt nextSubscriptionId(0);
+
+// value which callbacks are running in this thread
+static thread_local const AsyncValueCompactBase* notifyingValue = nullptr;
+
+AsyncValueCompactBase::AsyncValueCompactBase(ASYNC_VALUE_STATE state)
+    : m_word(static_cast<int>(state))
+{
+    AsyncMetrics::valueCreated(state);
+}
+
+AsyncValueCompactBase::~AsyncValueCompactBase()
+{
+    AsyncMetrics::valueDestroyed(loadState());
+}
+
+int AsyncValueCompactBase::subscribe(CallbackType callback)
+{
+    Q_ASSERT(callback);
+
+    auto id = nextSubscriptionId.fetchAndAddRelaxed(1) + 1;
+
+    auto& stripe = AsyncStripedLock::stripe(this);
+    QMutexLocker locker(&stripe.mutex);
+
+    m_subscribers.append(Subscriber{id, std::move(callback)});
+    m_word.fetchAndOrOrdered(SUBSCRIBED);
+
+    return id;
+}
+
+void AsyncValueCompactBase::unsubscribe(int subscription)
+{
+    // notifications are called under write lock
+    WriteLocker writeLocker(*this);
+
+    auto& stripe = AsyncStripedLock::stripe(this);
+    QMutexLocker locker(&stripe.mutex);
+
+    for (int i = 0; i < m_subscribers.size(); ++i)
+    {
+        if (m_subscribers[i].id == subscription)
+        {
+            m_subscribers.remove(i);
+            break;
+        }
+    }
+
+    if (m_subscribers.isEmpty())
+        m_word.fetchAndAndOrdered(~SUBSCRIBED);
+}
+
+void AsyncValueCompactBase::lockWrite()
+{
+    for (int spin = 0;; ++spin)
+    {
+        auto word = m_word.loadAcquire();
+        if (!(word & WRITE_LOCKED))
+        {
+            if (m_word.testAndSetAcquire(word, word | WRITE_LOCKED))
+                return;
+        }
+        else if (spin >= spinCount)
+        {
+            park([](int word) { return word & WRITE_LOCKED; });
+        }
+    }
+}
+
+void AsyncValueCompactBase::unlockWrite()
+{
+    // the last access to the value by the producer,
+    // waiters may destroy the value once PUBLISHING is cleared
+    clearAndWake(WRITE_LOCKED | PUBLISHING);
+}
+
+void AsyncValueCompactBase::lockContent()
+{
+    Q_ASSERT(m_word.loadAcquire() & WRITE_LOCKED);
+
+    // new readers are blocked, wait for current ones
+    m_word.fetchAndOrOrdered(CONTENT_LOCKED);
+
+    for (int spin = 0; m_word.loadAcquire() & READERS_MASK; ++spin)
+    {
+        if (spin >= spinCount)
+            park([](int word) { return word & READERS_MASK; });
+    }
+}
+
+void AsyncValueCompactBase::unlockContent(ASYNC_VALUE_STATE state, bool contentIsError)
+{
+    AsyncMetrics::valueStateChanged(loadState(), state);
+
+    auto setBits = static_cast<int>(state) | (contentIsError ? CONTENT_IS_ERROR : 0);
+    if (state != ASYNC_VALUE_STATE::PROGRESS)
+        setBits |= PUBLISHING;
+
+    clearAndWake(CONTENT_LOCKED | STATE_MASK | CONTENT_IS_ERROR, setBits);
+}
+
+void AsyncValueCompactBase::lockRead()
+{
+    for (int spin = 0;; ++spin)
+    {
+        auto word = m_word.loadAcquire();
+        if (!(word & CONTENT_LOCKED))
+        {
+            if (m_word.testAndSetAcquire(word, word + READER))
+                return;
+        }
+        else if (spin >= spinCount)
+        {
+            park([](int word) { return word & CONTENT_LOCKED; });
+        }
+    }
+}
+
+void AsyncValueCompactBase::unlockRead()
+{
+    auto word = m_word.fetchAndAddOrdered(-READER);
+
+    // the last reader wakes up the writer
+    if ((word & READERS_MASK) == READER && (word & PARKED))
+        clearAndWake(0);
+}
+
+void AsyncValueCompactBase::waitNoProgress()
+{
+    auto isProgress = [](int word) {
+        return (word & STATE_MASK) == static_cast<int>(ASYNC_VALUE_STATE::PROGRESS);
+    };
+
+    while (isProgress(m_word.loadAcquire()))
+        park(isProgress);
+}
+
+void AsyncValueCompactBase::waitPublished()
+{
+    // callbacks run under write lock of the producer
+    if (notifyingValue == this)
+        return;
+
+    auto isPublishing = [](int word) {
+        return word & PUBLISHING;
+    };
+
+    while (isPublishing(m_word.loadAcquire()))
+        park(isPublishing);
+}
+
+void AsyncValueCompactBase::notify(ASYNC_VALUE_STATE state)
+{
+    if (!(m_word.loadAcquire() & SUBSCRIBED))
+        return;
+
+    // call copy of subscribers to allow subscribe from callbacks
+    QVector<Subscriber> subscribers;
+    {
+        auto& stripe = AsyncStripedLock::stripe(this);
+        QMutexLocker locker(&stripe.mutex);
+        subscribers = m_subscribers;
+    }
+
+    auto previousValue = notifyingValue;
+    notifyingValue = this;
+    SCOPE_EXIT {
+        notifyingValue = previousValue;
+    };
+
+    for (const auto& subscriber : subscribers)
+        subscriber.callback(state);
+}
+
+template <typename IsBlocked>
+void AsyncValueCompactBase::park(IsBlocked isBlocked)
+{
+    auto& stripe = AsyncStripedLock::stripe(this);
+    QMutexLocker locker(&stripe.mutex);
+
+    auto word = m_word.loadAcquire();
+    if (!isBlocked(word))
+        return;
+
+    // PARKED is set under the stripe mutex, so clearAndWake cannot miss this thread
+    if (!(word & PARKED) && !m_word.testAndSetOrdered(word, word | PARKED))
+        return;
+
+    stripe.condition.wait(&stripe.mutex);
+}
+
+void AsyncValueCompactBase::clearAndWake(int bits, int setBits)
+{
+    auto word = m_word.loadAcquire();
+    while (!m_word.testAndSetOrdered(word, (word & ~(bits | PARKED)) | setBits, word))
+    {
+    }
+
+    if (!(word & PARKED))
+        return;
+
+    auto& stripe = AsyncStripedLock::stripe(this);
+    QMutexLocker locker(&stripe.mutex);
+    stripe.condition.wakeAll();
+}
@@ -0,0 +1,137 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_VALUE_COMPACT_BASE_H
+#define ASYNC_VALUE_COMPACT_BASE_H
+
+#include <functional>
+#include <QAtomicInt>
+#include <QVector>
+#include "AsyncValueBase.h"
+
+// base of compact async values
+// whole synchronization state is packed into one atomic word:
+// value state, write lock, content lock with readers count, "parked" and "publishing" flags.
+// threads that cannot take the word spin shortly and then sleep
+// on the AsyncStripedLock stripe of the value
+class AsyncValueCompactBase
+{
+    Q_DISABLE_COPY(AsyncValueCompactBase)
+
+public:
+    using CallbackType = std::function<void(ASYNC_VALUE_STATE)>;
+
+    // callback is called in the thread that changed value state
+    // it may access the value but shouldn't change it (like direct connected slots)
+    // returns subscription id to unsubscribe
+    int subscribe(CallbackType callback);
+    // waits for running notification, so callback is never called after unsubscribe
+    // (and unsubscribe cannot be called from callbacks)
+    void unsubscribe(int subscription);
+
+protected:
+    explicit AsyncValueCompactBase(ASYNC_VALUE_STATE state);
+    ~AsyncValueCompactBase();
+
+    // serializes value changes (like AsyncValueBase::m_writeLock)
+    void lockWrite();
+    void unlockWrite();
+
+    // exclusive content lock, should be called under write lock
+    void lockContent();
+    // releases content lock and publishes new state and content kind
+    // leaving progress state marks the value as publishing until unlockWrite
+    void unlockContent(ASYNC_VALUE_STATE state, bool contentIsError);
+
+    // shared content lock
+    void lockRead();
+    void unlockRead();
+
+    // should be called under any lock
+    ASYNC_VALUE_STATE loadState() const
+    {
+        return static_cast<ASYNC_VALUE_STATE>(m_word.loadAcquire() & STATE_MASK);
+    }
+
+    // true if content is error, false if content is value
+    bool contentIsError() const
+    {
+        return m_word.loadAcquire() & CONTENT_IS_ERROR;
+    }
+
+    // sleeps until value leaves progress state
+    void waitNoProgress();
+    // sleeps until the producer which published the state releases write lock,
+    // after that the value may be destroyed
+    void waitPublished();
+
+    // calls subscribed callbacks
+    void notify(ASYNC_VALUE_STATE state);
+
+    class WriteLocker
+    {
+        Q_DISABLE_COPY(WriteLocker)
+
+    public:
+        explicit WriteLocker(AsyncValueCompactBase& value) : m_value(value) { m_value.lockWrite(); }
+        ~WriteLocker() { m_value.unlockWrite(); }
+
+    private:
+        AsyncValueCompactBase& m_value;
+    };
+
+    class ReadLocker
+    {
+        Q_DISABLE_COPY(ReadLocker)
+
+    public:
+        explicit ReadLocker(AsyncValueCompactBase& value) : m_value(value) { m_value.lockRead(); }
+        ~ReadLocker() { m_value.unlockRead(); }
+
+    private:
+        AsyncValueCompactBase& m_value;
+    };
+
+private:
+    enum : int
+    {
+        STATE_MASK = 0x3,
+        CONTENT_IS_ERROR = 1 << 2,
+        WRITE_LOCKED = 1 << 3,
+        CONTENT_LOCKED = 1 << 4,
+        PARKED = 1 << 5,
+        SUBSCRIBED = 1 << 6,
+        PUBLISHING = 1 << 7,
+        READER = 1 << 8,
+        READERS_MASK = ~(READER - 1)
+    };
+
+    template <typename IsBlocked>
+    void park(IsBlocked isBlocked);
+    void clearAndWake(int bits, int setBits = 0);
+
+    QAtomicInt m_word;
+
+    struct Subscriber
+    {
+        int id;
+        CallbackType callback;
+    };
+    // guarded by the stripe mutex
+    QVector<Subscriber> m_subscribers;
+};
+
+#endif // ASYNC_VALUE_COMPACT_BASE_H
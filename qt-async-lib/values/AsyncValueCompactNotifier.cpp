@@ -0,0 +1,31 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncValueCompactNotifier.h"
+
+AsyncValueCompactNotifier::AsyncValueCompactNotifier(AsyncValueCompactBase& value, QObject* parent)
+    : QObject(parent),
+      m_value(value),
+      m_subscription(value.subscribe([this](ASYNC_VALUE_STATE state) {
+          emit stateChanged(state);
+      }))
+{
+}
+
+AsyncValueCompactNotifier::~AsyncValueCompactNotifier()
+{
+    m_value.unsubscribe(m_subscription);
+}
@@ -0,0 +1,43 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_VALUE_COMPACT_NOTIFIER_H
+#define ASYNC_VALUE_COMPACT_NOTIFIER_H
+
+#include "AsyncValueCompactBase.h"
+
+// exposes state changes of compact async value as Qt signal
+// create it only for values that are actually observed (shown in a widget, etc.)
+// notifier should be destroyed before the value and not from directly connected slots
+class AsyncValueCompactNotifier : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AsyncValueCompactNotifier)
+
+public:
+    explicit AsyncValueCompactNotifier(AsyncValueCompactBase& value, QObject* parent = nullptr);
+    ~AsyncValueCompactNotifier() override;
+
+signals:
+    // emitted in the thread that changed the value
+    void stateChanged(ASYNC_VALUE_STATE state);
+
+private:
+    AsyncValueCompactBase& m_value;
+    const int m_subscription;
+};
+
+#endif // ASYNC_VALUE_COMPACT_NOTIFIER_H
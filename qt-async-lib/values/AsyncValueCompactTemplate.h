@@ -0,0 +1,350 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_VALUE_COMPACT_TEMPLATE_H
+#define ASYNC_VALUE_COMPACT_TEMPLATE_H
+
+#include <memory>
+#include "AsyncValueTemplate.h"
+#include "AsyncValueCompactBase.h"
+
+// async value for huge collections: no QObject, no own mutexes,
+// only an atomic word, content pointer and progress pointer
+// has the same access/emplace/wait API as AsyncValueTemplate and works with asyncValueRunXXX functions
+// state changes are delivered to callbacks (see subscribe) or by AsyncValueCompactNotifier
+// value and error are allocated by new, progresses come from per-thread pools
+template <typename ValueType_t, typename ErrorType_t, typename ProgressType_t, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault>
+class AsyncValueCompactTemplate : public AsyncValueCompactBase
+{
+public:
+    using ValueType = ValueType_t;
+    using ErrorType = ErrorType_t;
+    using ProgressType = ProgressType_t;
+
+    template <typename... Args>
+    explicit AsyncValueCompactTemplate(AsyncInitByValue, Args&& ...arguments)
+        : AsyncValueCompactBase(ASYNC_VALUE_STATE::VALUE)
+    {
+        emplaceValue(std::forward<Args>(arguments)...);
+    }
+
+    template <typename... Args>
+    explicit AsyncValueCompactTemplate(AsyncInitByError, Args&& ...arguments)
+        : AsyncValueCompactBase(ASYNC_VALUE_STATE::ERROR)
+    {
+        emplaceError(std::forward<Args>(arguments)...);
+    }
+
+    ~AsyncValueCompactTemplate()
+    {
+        if (loadState() == ASYNC_VALUE_STATE::PROGRESS)
+            m_trackErrors.inProgressWhileDestruct();
+
+        destroyContent(m_content, contentIsError());
+    }
+
+    template <typename... Args>
+    void emplaceValue(Args&& ...arguments)
+    {
+        moveValue(std::make_unique<ValueType>(std::forward<Args>(arguments)...));
+    }
+
+    void moveValue(std::unique_ptr<ValueType> value)
+    {
+        setContent(value.release(), false);
+    }
+
+    template <typename... Args>
+    void emplaceError(Args&& ...arguments)
+    {
+        moveError(std::make_unique<ErrorType>(std::forward<Args>(arguments)...));
+    }
+
+    void moveError(std::unique_ptr<ErrorType> error)
+    {
+        setContent(error.release(), true);
+    }
+
+    bool startProgress(AsyncUniquePtr<ProgressType> progress)
+    {
+        Q_ASSERT(progress);
+
+        m_trackErrors.trackEmitDeadlock();
+
+        OldContent oldContent;
+
+        WriteLocker writeLocker(*this);
+
+        if (loadState() == ASYNC_VALUE_STATE::PROGRESS)
+        {
+            m_trackErrors.startProgressWhileInProgress();
+            return false;
+        }
+
+        lockContent();
+
+        oldContent = OldContent(m_content, contentIsError());
+        m_content = nullptr;
+        m_progress = std::move(progress);
+
+#ifdef QT_DEBUG
+        Q_ASSERT(!m_progress->isInUse() && "Progress is used already");
+        m_progress->setInUse(true);
+#endif
+
+        unlockContent(ASYNC_VALUE_STATE::PROGRESS, false);
+
+        emitStateChanged(ASYNC_VALUE_STATE::PROGRESS);
+
+        return true;
+    }
+
+    bool completeProgress(ProgressType* progress)
+    {
+#ifdef QT_DEBUG
+        Q_ASSERT(progress);
+        Q_ASSERT(progress->isInUse() && "Progress should be used");
+        progress->setInUse(false);
+#endif
+
+        AsyncUniquePtr<ProgressType> oldProgress;
+
+        WriteLocker writeLocker(*this);
+
+        if (progress != m_progress.get())
+        {
+            m_trackErrors.tryCompleteAlienProgress();
+            return false;
+        }
+
+        if (!m_content)
+        {
+            m_trackErrors.incompleteProgress();
+            return false;
+        }
+
+        auto isError = contentIsError();
+        auto state = isError ? ASYNC_VALUE_STATE::ERROR : ASYNC_VALUE_STATE::VALUE;
+
+        lockContent();
+        oldProgress = std::move(m_progress);
+        unlockContent(state, isError);
+
+        emitStateChanged(state);
+
+        return true;
+    }
+
+    template <typename ValuePred, typename ErrorPred, typename ProgressPred>
+    void access(ValuePred valuePred, ErrorPred errorPred, ProgressPred progressPred)
+    {
+        ReadLocker locker(*this);
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
+
+        switch (loadState())
+        {
+        case ASYNC_VALUE_STATE::VALUE:
+            valuePred(*static_cast<ValueType*>(m_content));
+            break;
+
+        case ASYNC_VALUE_STATE::ERROR:
+            errorPred(*static_cast<ErrorType*>(m_content));
+            break;
+
+        case ASYNC_VALUE_STATE::PROGRESS:
+            progressPred(*m_progress);
+            break;
+        }
+    }
+
+    template <typename ValuePred, typename ErrorPred>
+    bool access(ValuePred valuePred, ErrorPred errorPred)
+    {
+        ReadLocker locker(*this);
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
+
+        switch (loadState())
+        {
+        case ASYNC_VALUE_STATE::VALUE:
+            valuePred(*static_cast<ValueType*>(m_content));
+            return true;
+
+        case ASYNC_VALUE_STATE::ERROR:
+            errorPred(*static_cast<ErrorType*>(m_content));
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    template <typename Pred>
+    bool access(Pred valuePred)
+    {
+        ReadLocker locker(*this);
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
+
+        if (loadState() != ASYNC_VALUE_STATE::VALUE)
+            return false;
+
+        valuePred(*static_cast<ValueType*>(m_content));
+        return true;
+    }
+
+    template <typename Pred>
+    bool accessValue(Pred valuePred)
+    {
+        return access(valuePred);
+    }
+
+    template <typename Pred>
+    bool accessError(Pred errorPred)
+    {
+        ReadLocker locker(*this);
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
+
+        if (loadState() != ASYNC_VALUE_STATE::ERROR)
+            return false;
+
+        errorPred(*static_cast<ErrorType*>(m_content));
+        return true;
+    }
+
+    template <typename Pred>
+    bool accessProgress(Pred progressPred)
+    {
+        ReadLocker locker(*this);
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
+
+        if (loadState() != ASYNC_VALUE_STATE::PROGRESS)
+            return false;
+
+        progressPred(*m_progress);
+        return true;
+    }
+
+    template <typename ValuePred, typename ErrorPred>
+    void wait(ValuePred valuePred, ErrorPred errorPred)
+    {
+        // easy case we have value or error
+        if (!access(valuePred, errorPred))
+        {
+            AsyncWatchdogScope watchdogScope(ASYNC_STALL::WAIT, this, typeid(ValueType), "wait");
+
+            do
+            {
+                // value may return to progress state before access
+                waitNoProgress();
+            } while (!access(valuePred, errorPred));
+        }
+
+        // producer may still notify, so caller can't destroy the value yet
+        waitPublished();
+    }
+
+    void wait()
+    {
+        wait(AsyncNoOp(), AsyncNoOp());
+    }
+
+    // compact values don't keep memory resource
+    AsyncMemoryResource* memoryResource() const
+    {
+        return nullptr;
+    }
+
+    // compact values are not traced
+    void traceStarted()
+    {
+    }
+
+    void stopAndWait()
+    {
+        accessProgress([](ProgressType& progress){
+            progress.requestStop();
+        });
+        wait();
+    }
+
+private:
+    static void destroyContent(void* content, bool isError)
+    {
+        if (isError)
+            delete static_cast<ErrorType*>(content);
+        else
+            delete static_cast<ValueType*>(content);
+    }
+
+    // destroys replaced content after locks are released
+    class OldContent
+    {
+    public:
+        OldContent() = default;
+        OldContent(void* content, bool isError) : m_content(content), m_isError(isError) {}
+        OldContent& operator=(OldContent&& other)
+        {
+            std::swap(m_content, other.m_content);
+            std::swap(m_isError, other.m_isError);
+            return *this;
+        }
+        ~OldContent() { destroyContent(m_content, m_isError); }
+
+    private:
+        void* m_content = nullptr;
+        bool m_isError = false;
+    };
+
+    void setContent(void* content, bool isError)
+    {
+        m_trackErrors.trackEmitDeadlock();
+
+        OldContent oldContent;
+
+        WriteLocker writeLocker(*this);
+
+        lockContent();
+
+        oldContent = OldContent(m_content, contentIsError());
+        m_content = content;
+
+        // don't change state until stopProgress happen
+        auto state = loadState();
+        if (state != ASYNC_VALUE_STATE::PROGRESS)
+            state = isError ? ASYNC_VALUE_STATE::ERROR : ASYNC_VALUE_STATE::VALUE;
+
+        unlockContent(state, isError);
+
+        if (state != ASYNC_VALUE_STATE::PROGRESS)
+            emitStateChanged(state);
+    }
+
+    void emitStateChanged(ASYNC_VALUE_STATE state)
+    {
+        using EmitGuardType = typename TrackErrorsPolicy_t::EmitGuardType;
+        EmitGuardType emitGuard(m_trackErrors);
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "stateChanged");
+
+        notify(state);
+    }
+
+    // points to ValueType or ErrorType depending on contentIsError()
+    void* m_content = nullptr;
+    AsyncUniquePtr<ProgressType> m_progress;
+
+    TrackErrorsPolicy_t m_trackErrors;
+};
+
+#endif // ASYNC_VALUE_COMPACT_TEMPLATE_H
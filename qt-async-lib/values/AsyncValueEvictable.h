@@ -0,0 +1,293 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_VALUE_EVICTABLE_H
+#define ASYNC_VALUE_EVICTABLE_H
+
+#include "AsyncValueRunable.h"
+#include "AsyncEviction.h"
+
+// runable value which content may be evicted by AsyncEvictionManager
+// when memory budget is exceeded and the value wasn't accessed recently.
+// evicted value turns into error state and is rerun by the next access/wait
+// subclasses should call stopEviction() first in their destructor
+template <typename ValueType_t, typename ErrorType_t = AsyncError, typename ProgressType_t = AsyncProgressRerun, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault, typename TracePolicy_t = AsyncTracePolicyDefault, typename NotifyPolicy_t = AsyncNotifyPolicyDefault>
+class AsyncValueEvictable : public AsyncValueRunableAbstract<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>, public AsyncEvictableEntry
+{
+public:
+    using ValueType = ValueType_t;
+    using ErrorType = ErrorType_t;
+    using ProgressType = ProgressType_t;
+    using BaseType = AsyncValueRunableAbstract<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>;
+
+    // constructors
+    template <typename... Args>
+    explicit AsyncValueEvictable(Args&& ...arguments)
+        : BaseType(std::forward<Args>(arguments)...)
+    {
+        trackValue();
+    }
+
+    ~AsyncValueEvictable() override
+    {
+        // eviction calls virtual functions, they are destroyed already at this point
+        Q_ASSERT(m_evictionStopped.loadAcquire() && "Subclass destructor should call stopEviction()");
+        m_manager->remove(this);
+    }
+
+    // should be called before the value is used by other threads
+    AsyncEvictionManager* evictionManager() const { return m_manager; }
+    void setEvictionManager(AsyncEvictionManager* manager)
+    {
+        Q_ASSERT(manager);
+        Q_ASSERT(!m_evictionStopped.loadAcquire());
+        m_manager->remove(this);
+        m_manager = manager;
+        trackValue();
+    }
+
+    bool isEvicted() const
+    {
+        return m_evicted.loadAcquire();
+    }
+
+    template <typename... Args>
+    void emplaceValue(Args&& ...arguments)
+    {
+        moveValue(asyncMakeUnique<ValueType>(this->memoryResource(), std::forward<Args>(arguments)...));
+    }
+
+    void moveValue(AsyncUniquePtr<ValueType> value)
+    {
+        auto bytes = asyncValueByteSize(*value);
+
+        {
+            QMutexLocker locker(&m_evictLock);
+            m_evicted.storeRelease(0);
+            BaseType::moveValue(std::move(value));
+        }
+
+        if (!m_evictionStopped.loadAcquire())
+            m_manager->update(this, bytes);
+    }
+
+    template <typename... Args>
+    void emplaceError(Args&& ...arguments)
+    {
+        moveError(asyncMakeUnique<ErrorType>(this->memoryResource(), std::forward<Args>(arguments)...));
+    }
+
+    // errors are not tracked, so previous value size doesn't stay in the budget
+    void moveError(AsyncUniquePtr<ErrorType> error)
+    {
+        {
+            QMutexLocker locker(&m_evictLock);
+            m_evicted.storeRelease(0);
+            BaseType::moveError(std::move(error));
+        }
+
+        m_manager->remove(this);
+    }
+
+    template <typename ValuePred, typename ErrorPred, typename ProgressPred>
+    void access(ValuePred valuePred, ErrorPred errorPred, ProgressPred progressPred)
+    {
+        for (;;)
+        {
+            reloadIfEvicted();
+
+            bool isEvicted = false;
+            BaseType::access(valuePred, skipEvictedError(errorPred, isEvicted), progressPred);
+
+            if (!isEvicted)
+                break;
+        }
+
+        m_manager->touch(this);
+    }
+
+    template <typename ValuePred, typename ErrorPred>
+    bool access(ValuePred valuePred, ErrorPred errorPred)
+    {
+        for (;;)
+        {
+            reloadIfEvicted();
+
+            bool isEvicted = false;
+            auto result = BaseType::access(valuePred, skipEvictedError(errorPred, isEvicted));
+
+            if (!isEvicted)
+            {
+                m_manager->touch(this);
+                return result;
+            }
+        }
+    }
+
+    template <typename ValuePred, typename ErrorPred, typename ProgressPred>
+    bool accessIfChangedSince(quint64& version, ValuePred valuePred, ErrorPred errorPred, ProgressPred progressPred)
+    {
+        reloadIfEvicted();
+        if (!BaseType::accessIfChangedSince(version, valuePred, errorPred, progressPred))
+            return false;
+
+        m_manager->touch(this);
+        return true;
+    }
+
+    template <typename Pred>
+    bool access(Pred valuePred)
+    {
+        reloadIfEvicted();
+        if (!BaseType::access(valuePred))
+            return false;
+
+        m_manager->touch(this);
+        return true;
+    }
+
+    template <typename Pred>
+    bool accessValue(Pred valuePred)
+    {
+        return access(valuePred);
+    }
+
+    template <typename ValuePred, typename ErrorPred>
+    void wait(ValuePred valuePred, ErrorPred errorPred)
+    {
+        for (;;)
+        {
+            reloadIfEvicted();
+
+            bool isEvicted = false;
+            BaseType::wait(valuePred, skipEvictedError(errorPred, isEvicted));
+
+            if (!isEvicted)
+                break;
+        }
+
+        m_manager->touch(this);
+    }
+
+    void wait()
+    {
+        wait(AsyncNoOp(), AsyncNoOp());
+    }
+
+protected:
+    // stops tracking and waits for running eviction,
+    // should be called in subclass destructor while virtual functions are still valid
+    void stopEviction()
+    {
+        m_evictionStopped.storeRelease(1);
+        m_manager->remove(this);
+    }
+
+    // replaces evicted value, default implementation emplaces error with explanation
+    // should use BaseType::emplaceXXX functions
+    virtual void evictContentImpl()
+    {
+        BaseType::emplaceError(QString("Value was evicted to free memory."));
+    }
+
+    void evictImpl() final
+    {
+        // value is being changed right now and will be tracked again
+        if (!m_evictLock.tryLock())
+            return;
+
+        SCOPE_EXIT {
+            m_evictLock.unlock();
+        };
+
+        // values in progress are tracked again on completion, errors are not tracked
+        if (!BaseType::accessValue(AsyncNoOp()))
+            return;
+
+        m_evicted.storeRelease(1);
+        m_reloadRequested = false;
+
+        m_emittingThread.storeRelease(QThread::currentThread());
+        evictContentImpl();
+        m_emittingThread.storeRelease(nullptr);
+
+        // directly connected slot has accessed the value
+        if (m_reloadRequested)
+            reload();
+    }
+
+private:
+    void trackValue()
+    {
+        qint64 bytes = 0;
+        if (BaseType::accessValue([&bytes](const ValueType& value) {
+            bytes = asyncValueByteSize(value);
+        }))
+            m_manager->update(this, bytes);
+    }
+
+    void reloadIfEvicted()
+    {
+        if (!m_evicted.loadAcquire())
+            return;
+
+        // cannot run the value while it's emitting state change, run it after emit
+        if (m_emittingThread.loadAcquire() == QThread::currentThread())
+        {
+            m_reloadRequested = true;
+            return;
+        }
+
+        QMutexLocker locker(&m_evictLock);
+        if (m_evicted.loadAcquire())
+            reload();
+    }
+
+    // should be called under m_evictLock
+    void reload()
+    {
+        m_emittingThread.storeRelease(QThread::currentThread());
+        this->run();
+        m_emittingThread.storeRelease(nullptr);
+
+        // value is in progress already, so nobody sees eviction error
+        m_evicted.storeRelease(0);
+    }
+
+    // readers concurrent with eviction may get eviction error, they should reload value and retry
+    template <typename ErrorPred>
+    auto skipEvictedError(ErrorPred& errorPred, bool& isEvicted)
+    {
+        return [this, &errorPred, &isEvicted](ErrorType& error) {
+            if (m_evicted.loadAcquire() && m_emittingThread.loadAcquire() != QThread::currentThread())
+                isEvicted = true;
+            else
+                errorPred(error);
+        };
+    }
+
+    AsyncEvictionManager* m_manager = AsyncEvictionManager::global();
+
+    QMutex m_evictLock;
+    QAtomicInt m_evicted;
+    QAtomicInt m_evictionStopped;
+    // thread that emits state change under m_evictLock
+    QAtomicPointer<QThread> m_emittingThread;
+    // accessed by emitting thread only
+    bool m_reloadRequested = false;
+};
+
+#endif // ASYNC_VALUE_EVICTABLE_H
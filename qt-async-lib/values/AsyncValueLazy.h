@@ -0,0 +1,143 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_VALUE_LAZY_H
+#define ASYNC_VALUE_LAZY_H
+
+#include "AsyncValueRunable.h"
+
+// runable value which is run by the first access or wait (including access by async widgets)
+// concurrent first accesses run the value exactly once
+// values that are never used are never calculated
+template <typename ValueType_t, typename ErrorType_t = AsyncError, typename ProgressType_t = AsyncProgressRerun, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault, typename TracePolicy_t = AsyncTracePolicyDefault, typename NotifyPolicy_t = AsyncNotifyPolicyDefault>
+class AsyncValueLazy : public AsyncValueRunableAbstract<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>
+{
+public:
+    using ValueType = ValueType_t;
+    using ErrorType = ErrorType_t;
+    using ProgressType = ProgressType_t;
+    using BaseType = AsyncValueRunableAbstract<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>;
+
+    // constructors, initial value or error is visible until the first access
+    // usually it's an error like "Not calculated"
+    using BaseType::BaseType;
+
+    // true if the value was run by access or explicitly
+    bool isStarted() const
+    {
+        return m_started.loadAcquire();
+    }
+
+    // runs the value if it wasn't run yet
+    void start()
+    {
+        if (m_started.loadAcquire())
+            return;
+
+        // access from slot connected to stateChanged during the first run
+        if (m_startingThread.loadAcquire() == QThread::currentThread())
+            return;
+
+        QMutexLocker locker(&m_startLock);
+        if (!m_started.loadAcquire())
+            runLocked();
+    }
+
+    // explicit run (for example by async widget in "run on visible" mode) starts the value too
+    void run()
+    {
+        if (m_startingThread.loadAcquire() == QThread::currentThread())
+        {
+            BaseType::run();
+            return;
+        }
+
+        QMutexLocker locker(&m_startLock);
+        runLocked();
+    }
+
+    template <typename ValuePred, typename ErrorPred, typename ProgressPred>
+    void access(ValuePred valuePred, ErrorPred errorPred, ProgressPred progressPred)
+    {
+        start();
+        BaseType::access(valuePred, errorPred, progressPred);
+    }
+
+    template <typename ValuePred, typename ErrorPred>
+    bool access(ValuePred valuePred, ErrorPred errorPred)
+    {
+        start();
+        return BaseType::access(valuePred, errorPred);
+    }
+
+    template <typename Pred>
+    bool access(Pred valuePred)
+    {
+        start();
+        return BaseType::access(valuePred);
+    }
+
+    template <typename Pred>
+    bool accessValue(Pred valuePred)
+    {
+        return access(valuePred);
+    }
+
+    template <typename Pred>
+    bool accessError(Pred errorPred)
+    {
+        start();
+        return BaseType::accessError(errorPred);
+    }
+
+    template <typename ValuePred, typename ErrorPred, typename ProgressPred>
+    bool accessIfChangedSince(quint64& version, ValuePred valuePred, ErrorPred errorPred, ProgressPred progressPred)
+    {
+        start();
+        return BaseType::accessIfChangedSince(version, valuePred, errorPred, progressPred);
+    }
+
+    template <typename ValuePred, typename ErrorPred>
+    void wait(ValuePred valuePred, ErrorPred errorPred)
+    {
+        start();
+        BaseType::wait(valuePred, errorPred);
+    }
+
+    void wait()
+    {
+        wait(AsyncNoOp(), AsyncNoOp());
+    }
+
+private:
+    // should be called under m_startLock
+    void runLocked()
+    {
+        m_startingThread.storeRelease(QThread::currentThread());
+        BaseType::run();
+        m_startingThread.storeRelease(nullptr);
+
+        // value is in progress already, so next accesses see the progress
+        m_started.storeRelease(1);
+    }
+
+    QMutex m_startLock;
+    QAtomicInt m_started;
+    // thread that runs the value under m_startLock
+    QAtomicPointer<QThread> m_startingThread;
+};
+
+#endif // ASYNC_VALUE_LAZY_H
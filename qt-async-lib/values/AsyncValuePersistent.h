@@ -0,0 +1,89 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_VALUE_PERSISTENT_H
+#define ASYNC_VALUE_PERSISTENT_H
+
+#include "AsyncValueRunable.h"
+#include "AsyncDiskCache.h"
+
+// runable value which calculated results are kept in AsyncDiskCache by key and version
+// loadOrRun publishes cached value immediately and runs the value only on cache miss
+// version should be changed when the way value is calculated changes
+template <typename ValueType_t, typename ErrorType_t = AsyncError, typename ProgressType_t = AsyncProgressRerun, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault, typename TracePolicy_t = AsyncTracePolicyDefault, typename NotifyPolicy_t = AsyncNotifyPolicyDefault>
+class AsyncValuePersistent : public AsyncValueRunableAbstract<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>
+{
+public:
+    using ValueType = ValueType_t;
+    using ErrorType = ErrorType_t;
+    using ProgressType = ProgressType_t;
+    using BaseType = AsyncValueRunableAbstract<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>;
+
+    template <typename... Args>
+    explicit AsyncValuePersistent(AsyncDiskCache* cache, QString key, quint32 version, Args&& ...arguments)
+        : BaseType(std::forward<Args>(arguments)...),
+          m_cache(cache),
+          m_key(std::move(key)),
+          m_version(version)
+    {
+        Q_ASSERT(m_cache);
+    }
+
+    AsyncDiskCache* cache() const { return m_cache; }
+    QString key() const { return m_key; }
+    quint32 version() const { return m_version; }
+
+    // returns true if value was loaded from the cache
+    bool loadOrRun()
+    {
+        if (load())
+            return true;
+
+        this->run();
+        return false;
+    }
+
+    // publishes cached value if it exists and has the same version
+    bool load()
+    {
+        auto value = asyncMakeUnique<ValueType>(this->memoryResource());
+        if (!m_cache->load(m_key, m_version, *value))
+            return false;
+
+        BaseType::moveValue(std::move(value));
+        return true;
+    }
+
+    template <typename... Args>
+    void emplaceValue(Args&& ...arguments)
+    {
+        moveValue(asyncMakeUnique<ValueType>(this->memoryResource(), std::forward<Args>(arguments)...));
+    }
+
+    // calculated value is written to the cache in background
+    void moveValue(AsyncUniquePtr<ValueType> value)
+    {
+        m_cache->store(m_key, m_version, *value);
+        BaseType::moveValue(std::move(value));
+    }
+
+private:
+    AsyncDiskCache* const m_cache;
+    const QString m_key;
+    const quint32 m_version;
+};
+
+#endif // ASYNC_VALUE_PERSISTENT_H
@@ -0,0 +1,316 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_VALUE_RUN_FUTURE_H
+#define ASYNC_VALUE_RUN_FUTURE_H
+
+#include <QFuture>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QException>
+#include <QTimer>
+#include <future>
+#include <memory>
+#include "../Config.h"
+#include "../third_party/scope_exit.h"
+#include "AsyncMetrics.h"
+#include "AsyncWatchdog.h"
+
+// default post processing for asyncValueRunFuture and asyncValueRunStdFuture
+// moves future result to the value, exception message or cancellation to the error
+struct AsyncFutureResult
+{
+    template <typename T, typename AsyncValueType>
+    void operator()(const QFuture<T>& future, AsyncValueType& value) const
+    {
+        try
+        {
+            if (future.isCanceled())
+            {
+                // rethrows exception if future was canceled by it,
+                // future stopped by the value may still run and is not waited for
+                if (future.isFinished())
+                    future.waitForFinished();
+                value.emplaceError(QString("Canceled"));
+                return;
+            }
+
+            value.emplaceValue(future.result());
+        }
+        catch (const std::exception& exception)
+        {
+            value.emplaceError(QString::fromLocal8Bit(exception.what()));
+        }
+        catch (...)
+        {
+            value.emplaceError(QString("Unknown exception"));
+        }
+    }
+
+    template <typename T, typename AsyncValueType>
+    void operator()(std::future<T>& future, AsyncValueType& value) const
+    {
+        try
+        {
+            value.emplaceValue(future.get());
+        }
+        catch (const std::exception& exception)
+        {
+            value.emplaceError(QString::fromLocal8Bit(exception.what()));
+        }
+        catch (...)
+        {
+            value.emplaceError(QString("Unknown exception"));
+        }
+    }
+};
+
+// feeds the value from QFuture without blocking any thread
+// func(const QFuture<T>&, AsyncValueType&) is called in the current thread when future finishes,
+// so the current thread should have event loop and shouldn't wait for the value
+// stop request of the value progress is checked on every progress report of the future
+// and every ASYNC_FUTURE_STOP_POLL_INTERVAL ms, it cancels the future and calls func right away:
+// futures of QtConcurrent::run ignore cancel() and keep running, their result is dropped
+template <typename AsyncValueType, typename T, typename Func, typename... ProgressArgs>
+bool asyncValueRunFuture(QFuture<T> future, AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
+{
+    auto progress = asyncMakeProgress(value, std::forward<ProgressArgs>(progressArgs)...);
+    auto progressPtr = progress.get();
+
+    if (!value.startProgress(std::move(progress)))
+        return false;
+
+    auto watchdogToken = AsyncWatchdog::beginRun(value, func, *progressPtr);
+
+    AsyncMetrics::runQueued(ASYNC_RUN_HELPER::FUTURE);
+    AsyncMetrics::runStarted(ASYNC_RUN_HELPER::FUTURE);
+    value.traceStarted();
+
+    auto watcher = new QFutureWatcher<T>();
+
+    // stop requests of futures without progress reports, timer is deleted with the watcher
+    auto stopTimer = new QTimer(watcher);
+    stopTimer->setInterval(ASYNC_FUTURE_STOP_POLL_INTERVAL);
+
+    // post processing, called once by finished signal or by stop request
+    auto complete = [ watcher,
+                      stopTimer,
+                      &value,
+                      progressPtr,
+                      watchdogToken,
+                      isCompleted = false,
+                      func = std::forward<Func>(func)]() mutable {
+        if (isCompleted)
+            return;
+        isCompleted = true;
+
+        SCOPE_EXIT {
+            watcher->deleteLater();
+            stopTimer->stop();
+            AsyncMetrics::runFinished(ASYNC_RUN_HELPER::FUTURE, *progressPtr);
+            AsyncWatchdog::end(watchdogToken);
+            // finish progress
+            value.completeProgress(progressPtr);
+        };
+
+        func(watcher->future(), value);
+    };
+    auto sharedComplete = std::make_shared<decltype(complete)>(std::move(complete));
+
+    // forward progress and stop requests
+    QObject::connect(watcher, &QFutureWatcherBase::progressValueChanged, [watcher, progressPtr, sharedComplete](int progressValue) {
+        // progress is destroyed already if the run was stopped
+        if (watcher->isCanceled())
+            return;
+
+        auto minimum = watcher->progressMinimum();
+        progressPtr->setProgress(progressValue - minimum, watcher->progressMaximum() - minimum);
+
+        if (progressPtr->isStopRequested())
+        {
+            watcher->cancel();
+            (*sharedComplete)();
+        }
+    });
+
+    QObject::connect(stopTimer, &QTimer::timeout, [watcher, progressPtr, sharedComplete]() {
+        if (!progressPtr->isStopRequested())
+            return;
+
+        watcher->cancel();
+        (*sharedComplete)();
+    });
+
+    QObject::connect(watcher, &QFutureWatcherBase::finished, [sharedComplete]() {
+        (*sharedComplete)();
+    });
+
+    watcher->setFuture(future);
+    stopTimer->start();
+
+    return true;
+}
+
+// feeds the value from std::future without blocking any thread
+// future is polled by timer every pollInterval ms in the current thread,
+// func(std::future<T>&, AsyncValueType&) is called in the current thread when future is ready
+template <typename AsyncValueType, typename T, typename Func, typename... ProgressArgs>
+bool asyncValueRunStdFuture(std::future<T> future, int pollInterval, AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
+{
+    auto progress = asyncMakeProgress(value, std::forward<ProgressArgs>(progressArgs)...);
+    auto progressPtr = progress.get();
+
+    if (!value.startProgress(std::move(progress)))
+        return false;
+
+    auto watchdogToken = AsyncWatchdog::beginRun(value, func, *progressPtr);
+
+    AsyncMetrics::runQueued(ASYNC_RUN_HELPER::FUTURE);
+    AsyncMetrics::runStarted(ASYNC_RUN_HELPER::FUTURE);
+    value.traceStarted();
+
+    auto timer = new QTimer();
+    timer->setInterval(pollInterval);
+
+    // std::future is not copyable, share it with the timer slot
+    auto sharedFuture = std::make_shared<std::future<T>>(std::move(future));
+
+    QObject::connect(timer, &QTimer::timeout, [ timer,
+                                                sharedFuture,
+                                                &value,
+                                                progressPtr,
+                                                watchdogToken,
+                                                func = std::forward<Func>(func)]() mutable {
+        if (sharedFuture->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return;
+
+        timer->stop();
+
+        SCOPE_EXIT {
+            timer->deleteLater();
+            AsyncMetrics::runFinished(ASYNC_RUN_HELPER::FUTURE, *progressPtr);
+            AsyncWatchdog::end(watchdogToken);
+            // finish progress
+            value.completeProgress(progressPtr);
+        };
+
+        func(*sharedFuture, value);
+    });
+
+    timer->start();
+
+    return true;
+}
+
+// exception reported to QFuture returned by asyncValueToFuture if the value ends with error
+template <typename ErrorType>
+class AsyncErrorException : public QException
+{
+public:
+    explicit AsyncErrorException(ErrorType error)
+        : m_error(std::move(error))
+    {
+    }
+
+    const ErrorType& error() const { return m_error; }
+
+    void raise() const override { throw *this; }
+    AsyncErrorException* clone() const override { return new AsyncErrorException(*this); }
+
+private:
+    ErrorType m_error;
+};
+
+// exposes the value as QFuture without blocking any thread
+// future finishes with the value copy or AsyncErrorException when the value leaves progress state
+// progress is reported in 0..1000 range and future cancellation requests the value progress to stop
+// value is tracked by stateChanged signal and progress timer in the current thread event loop
+template <typename AsyncValueType>
+QFuture<typename AsyncValueType::ValueType> asyncValueToFuture(AsyncValueType& value)
+{
+    using ValueType = typename AsyncValueType::ValueType;
+    using ErrorType = typename AsyncValueType::ErrorType;
+    using ProgressType = typename AsyncValueType::ProgressType;
+
+    struct Bridge
+    {
+        QFutureInterface<ValueType> future;
+        QMetaObject::Connection stateConnection;
+        QMetaObject::Connection destroyedConnection;
+    };
+
+    auto bridge = std::make_shared<Bridge>();
+    bridge->future.reportStarted();
+    bridge->future.setProgressRange(0, 1000);
+
+    // timer polls progress and is the context of connections,
+    // so slots are called in the current thread
+    // deleting the timer releases the bridge
+    auto timer = new QTimer();
+    timer->setInterval(ASYNC_PROGRESS_WIDGET_UPDATE_TIMEOUT);
+
+    auto finish = [bridge, timer]() {
+        timer->stop();
+        QObject::disconnect(bridge->stateConnection);
+        QObject::disconnect(bridge->destroyedConnection);
+        bridge->future.reportFinished();
+        timer->deleteLater();
+    };
+
+    // returns true if the value has finished
+    auto update = [bridge, &value, finish]() {
+        if (bridge->future.isFinished())
+            return true;
+
+        bool isFinished = value.access([&bridge](const ValueType& value) {
+            bridge->future.reportResult(value);
+        }, [&bridge](const ErrorType& error) {
+            bridge->future.reportException(AsyncErrorException<ErrorType>(error));
+        });
+
+        if (isFinished)
+        {
+            finish();
+            return true;
+        }
+
+        value.accessProgress([&bridge](ProgressType& progress) {
+            if (bridge->future.isCanceled())
+                progress.requestStop();
+
+            bridge->future.setProgressValue(static_cast<int>(progress.progress() * 1000));
+        });
+
+        return false;
+    };
+
+    if (update())
+        return bridge->future.future();
+
+    bridge->stateConnection = QObject::connect(&value, &AsyncValueBase::stateChanged, timer, update);
+    // value should outlive the future, but if it's destroyed in the current thread the future is canceled
+    bridge->destroyedConnection = QObject::connect(&value, &QObject::destroyed, timer, [bridge, finish]() {
+        QObject::disconnect(bridge->stateConnection);
+        bridge->future.reportCanceled();
+        finish();
+    });
+    QObject::connect(timer, &QTimer::timeout, update);
+    timer->start();
+
+    return bridge->future.future();
+}
+
+#endif // ASYNC_VALUE_RUN_FUTURE_H
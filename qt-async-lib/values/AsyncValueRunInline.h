@@ -0,0 +1,143 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_VALUE_RUN_INLINE_H
+#define ASYNC_VALUE_RUN_INLINE_H
+
+#include <QElapsedTimer>
+#include <functional>
+#include <type_traits>
+#include "../Config.h"
+#include "../third_party/scope_exit.h"
+#include "AsyncMetrics.h"
+#include "AsyncWatchdog.h"
+#include "AsyncValueRunThreadPool.h"
+
+// runs calculation in the calling thread without progress state
+// value or error assigned by func is published with single stateChanged
+// returns false if the value is in progress already
+// NOTE: the check is not atomic with the run, so caller should own the value exclusively:
+// a run started by other thread while func works gets func result as its own
+template <typename AsyncValueType, typename Func, typename... ProgressArgs>
+bool asyncValueRunInline(AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
+{
+    // value is being calculated by other run
+    if (value.accessProgress(AsyncNoOp()))
+        return false;
+
+    // progress is passed to func but never published
+    auto progress = asyncMakeProgress(value, std::forward<ProgressArgs>(progressArgs)...);
+
+    auto watchdogToken = AsyncWatchdog::beginRun(value, func, *progress);
+
+    AsyncMetrics::runQueued(ASYNC_RUN_HELPER::INLINE);
+    AsyncMetrics::runStarted(ASYNC_RUN_HELPER::INLINE);
+
+    SCOPE_EXIT {
+        AsyncMetrics::runFinished(ASYNC_RUN_HELPER::INLINE, *progress);
+        AsyncWatchdog::end(watchdogToken);
+    };
+
+    func(*progress, value);
+
+    return true;
+}
+
+// running average duration of calculations
+class AsyncRunEstimate
+{
+    Q_DISABLE_COPY(AsyncRunEstimate)
+
+public:
+    AsyncRunEstimate() = default;
+
+    // negative if there were no measurements
+    qint64 averageNs() const
+    {
+        return m_averageNs.loadAcquire();
+    }
+
+    void update(qint64 durationNs)
+    {
+        auto average = m_averageNs.loadAcquire();
+        // races between concurrent updates only lose some measurements
+        m_averageNs.storeRelease(average < 0 ? durationNs : average + (durationNs - average) / 8);
+    }
+
+    // estimate shared by all calculations of Func type
+    template <typename Func>
+    static AsyncRunEstimate& of()
+    {
+        static AsyncRunEstimate estimate;
+        return estimate;
+    }
+
+private:
+    QAtomicInteger<qint64> m_averageNs{-1};
+};
+
+// detects functor types shared by different routines
+template <typename Func>
+struct AsyncIsTypeErasedFunc : std::is_pointer<Func> {};
+
+template <typename Signature>
+struct AsyncIsTypeErasedFunc<std::function<Signature>> : std::true_type {};
+
+// runs calculation in the calling thread if it usually takes less than ASYNC_INLINE_RUN_THRESHOLD microseconds,
+// otherwise (or if there is no estimate yet) runs it in the thread pool
+// estimate should outlive all runs started with it
+template <typename AsyncValueType, typename Func, typename... ProgressArgs>
+bool asyncValueRunAdaptive(QThreadPool *pool, AsyncRunEstimate& estimate, AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
+{
+    // func may be a mutable lambda
+    auto measuredFunc = [&estimate, func = std::forward<Func>(func)](auto& progress, auto& value) mutable {
+        QElapsedTimer timer;
+        timer.start();
+        func(progress, value);
+        estimate.update(timer.nsecsElapsed());
+    };
+
+    auto averageNs = estimate.averageNs();
+    if (averageNs >= 0 && averageNs < ASYNC_INLINE_RUN_THRESHOLD * 1000
+            && asyncValueRunInline(value, measuredFunc, progressArgs...))
+        return true;
+
+    return asyncValueRunThreadPool(pool, value, std::move(measuredFunc), std::forward<ProgressArgs>(progressArgs)...);
+}
+
+template <typename AsyncValueType, typename Func, typename... ProgressArgs>
+bool asyncValueRunAdaptive(AsyncRunEstimate& estimate, AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
+{
+    return asyncValueRunAdaptive(QThreadPool::globalInstance(), estimate, value, std::forward<Func>(func), std::forward<ProgressArgs>(progressArgs)...);
+}
+
+// estimates calculations by Func type, so every routine should have its own lambda or functor type
+template <typename AsyncValueType, typename Func, typename... ProgressArgs>
+bool asyncValueRunAdaptive(QThreadPool *pool, AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
+{
+    using FuncType = std::decay_t<Func>;
+    static_assert(!AsyncIsTypeErasedFunc<FuncType>::value, "Function pointers and std::function are shared by different routines, pass AsyncRunEstimate explicitly");
+
+    return asyncValueRunAdaptive(pool, AsyncRunEstimate::of<FuncType>(), value, std::forward<Func>(func), std::forward<ProgressArgs>(progressArgs)...);
+}
+
+template <typename AsyncValueType, typename Func, typename... ProgressArgs>
+bool asyncValueRunAdaptive(AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
+{
+    return asyncValueRunAdaptive(QThreadPool::globalInstance(), value, std::forward<Func>(func), std::forward<ProgressArgs>(progressArgs)...);
+}
+
+#endif // ASYNC_VALUE_RUN_INLINE_H
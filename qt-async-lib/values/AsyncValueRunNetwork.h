@@ -20,16 +20,22 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include "../third_party/scope_exit.h"
+#include "AsyncMetrics.h"
+#include "AsyncWatchdog.h"
 
 template <typename AsyncValueType, typename Func, typename... ProgressArgs>
 bool asyncValueRunNetwork(QNetworkReply* reply, AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
 {
-    auto progress = std::make_unique<typename AsyncValueType::ProgressType>(std::forward<ProgressArgs>(progressArgs)...);
+    auto progress = asyncMakeProgress(value, std::forward<ProgressArgs>(progressArgs)...);
     auto progressPtr = progress.get();
 
     if (!value.startProgress(std::move(progress)))
         return false;
 
+    auto watchdogToken = AsyncWatchdog::beginRun(value, func, *progressPtr);
+
+    AsyncMetrics::runQueued(ASYNC_RUN_HELPER::NETWORK);
+
     // forward progress
     QObject::connect(reply, &QNetworkReply::downloadProgress, [progressPtr](qint64 bytesReceived, qint64 bytesTotal){
         progressPtr->setProgress(bytesReceived, bytesTotal);
@@ -39,9 +45,15 @@ bool asyncValueRunNetwork(QNetworkReply* reply, AsyncValueType& value, Func&& fu
     QObject::connect(reply, &QNetworkReply::finished, [ reply,
                                                         &value,
                                                         progressPtr,
+                                                        watchdogToken,
                                                         func = std::forward<Func>(func)](){
+        value.traceStarted();
+        AsyncMetrics::runStarted(ASYNC_RUN_HELPER::NETWORK);
+
         SCOPE_EXIT {
             reply->deleteLater();
+            AsyncMetrics::runFinished(ASYNC_RUN_HELPER::NETWORK, *progressPtr);
+            AsyncWatchdog::end(watchdogToken);
             // finish progress
             value.completeProgress(progressPtr);
         };
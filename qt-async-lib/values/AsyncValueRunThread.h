@@ -19,18 +19,31 @@
 
 #include <QThread>
 #include "../third_party/scope_exit.h"
+#include "AsyncMetrics.h"
+#include "AsyncWatchdog.h"
 
 template <typename AsyncValueType, typename Func, typename... ProgressArgs>
 bool asyncValueRunThread(AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
 {
-    auto progress = std::make_unique<typename AsyncValueType::ProgressType>(std::forward<ProgressArgs>(progressArgs)...);
+    auto progress = asyncMakeProgress(value, std::forward<ProgressArgs>(progressArgs)...);
     auto progressPtr = progress.get();
 
     if (!value.startProgress(std::move(progress)))
         return false;
 
-    auto thread = QThread::create([&value, progressPtr, func = std::forward<Func>(func)]() {
+    auto watchdogToken = AsyncWatchdog::beginRun(value, func, *progressPtr);
+
+    AsyncMetrics::runQueued(ASYNC_RUN_HELPER::THREAD);
+
+    auto thread = QThread::create([&value, progressPtr, watchdogToken, func = std::forward<Func>(func)]() {
+        value.traceStarted();
+        AsyncMetrics::runStarted(ASYNC_RUN_HELPER::THREAD);
+        progressPtr->attachThread(QThread::currentThread());
+
         SCOPE_EXIT {
+            progressPtr->detachThread();
+            AsyncMetrics::runFinished(ASYNC_RUN_HELPER::THREAD, *progressPtr);
+            AsyncWatchdog::end(watchdogToken);
             // finish progress
             value.completeProgress(progressPtr);
         };
@@ -40,7 +53,12 @@ bool asyncValueRunThread(AsyncValueType& value, Func&& func, ProgressArgs&& ...p
     });
 
     if (!thread)
+    {
+        // run will never start, don't leave it in metrics and watchdog
+        AsyncMetrics::runFinished(ASYNC_RUN_HELPER::THREAD, *progressPtr);
+        AsyncWatchdog::end(watchdogToken);
         return false;
+    }
 
     // delete thread on complete
     QObject::connect(thread, &QThread::finished, thread, &QObject::deleteLater);
@@ -18,27 +18,50 @@
 #define ASYNC_VALUE_RUN_THREAD_POOL_H
 
 #include <QThreadPool>
-#include <QtConcurrent>
 #include "../third_party/scope_exit.h"
+#include "AsyncMetrics.h"
+#include "AsyncWatchdog.h"
+#include "AsyncRunnable.h"
 
 template <typename AsyncValueType, typename Func, typename... ProgressArgs>
 bool asyncValueRunThreadPool(QThreadPool *pool, AsyncValueType& value, Func&& func, ProgressArgs&& ...progressArgs)
 {
-    auto progress = std::make_unique<typename AsyncValueType::ProgressType>(std::forward<ProgressArgs>(progressArgs)...);
+    auto progress = asyncMakeProgress(value, std::forward<ProgressArgs>(progressArgs)...);
     auto progressPtr = progress.get();
 
     if (!value.startProgress(std::move(progress)))
         return false;
 
-    QtConcurrent::run(pool, [&value, progressPtr, func = std::forward<Func>(func)](){
+    auto watchdogToken = AsyncWatchdog::beginRun(value, func, *progressPtr);
+
+    AsyncMetrics::runQueued(ASYNC_RUN_HELPER::THREAD_POOL);
+    auto poolMetrics = AsyncMetrics::poolQueued(pool);
+
+    // calculation dropped by QThreadPool::clear() runs stopped in the clearing thread,
+    // so the value doesn't stay in progress (the pool is locked there, so don't start new runs on it)
+    auto discard = [progressPtr](auto& run) {
+        progressPtr->requestStop();
+        run();
+    };
+
+    AsyncRunnable::start(pool, [&value, progressPtr, poolMetrics, watchdogToken, func = std::forward<Func>(func)]() mutable {
+        value.traceStarted();
+        AsyncMetrics::runStarted(ASYNC_RUN_HELPER::THREAD_POOL);
+        AsyncMetrics::poolStarted(poolMetrics);
+        progressPtr->attachThread(QThread::currentThread());
+
         SCOPE_EXIT {
+            progressPtr->detachThread();
+            AsyncMetrics::poolFinished(poolMetrics);
+            AsyncMetrics::runFinished(ASYNC_RUN_HELPER::THREAD_POOL, *progressPtr);
+            AsyncWatchdog::end(watchdogToken);
             // finish progress
             value.completeProgress(progressPtr);
         };
 
         // run calculation
         func(*progressPtr, value);
-    });
+    }, discard);
 
     return true;
 }
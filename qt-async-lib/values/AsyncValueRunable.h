@@ -20,17 +20,20 @@
 #include "AsyncValueTemplate.h"
 #include "AsyncError.h"
 #include "AsyncProgress.h"
+#include "../third_party/scope_exit.h"
+#include <QMutex>
+#include <QThread>
 #include <functional>
 
-template <typename ValueType_t, typename ErrorType_t = AsyncError, typename ProgressType_t = AsyncProgressRerun, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault>
-class AsyncValueRunableAbstract : public AsyncValueTemplate<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t>
+template <typename ValueType_t, typename ErrorType_t = AsyncError, typename ProgressType_t = AsyncProgressRerun, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault, typename TracePolicy_t = AsyncTracePolicyDefault, typename NotifyPolicy_t = AsyncNotifyPolicyDefault>
+class AsyncValueRunableAbstract : public AsyncValueTemplate<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>
 {
 public:
     using ValueType = ValueType_t;
     using ErrorType = ErrorType_t;
     using ProgressType = ProgressType_t;
-    using ThisType = AsyncValueRunableAbstract<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t>;
-    using BaseType = AsyncValueTemplate<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t>;
+    using ThisType = AsyncValueRunableAbstract<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>;
+    using BaseType = AsyncValueTemplate<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>;
     using RunFnType = std::function<void(ProgressType&, ThisType&)>;
 
     // constructors
@@ -38,14 +41,34 @@ public:
 
     void run()
     {
-        bool isInProgress = BaseType::accessProgress([](ProgressType& progress) {
-            // if we are in progress already -> just request rerun
-            progress.requestRerun();
-        });
+        // nested run() from the thread that starts progress (slot connected to stateChanged)
+        if (m_runningThread.loadAcquire() == QThread::currentThread())
+        {
+            runLocked();
+            return;
+        }
+
+        // concurrent run() calls should check and start progress atomically
+        QMutexLocker locker(&m_runLock);
+        runLocked();
+    }
 
-        if (isInProgress)
+protected:
+    virtual void deferImpl(RunFnType&& func) = 0;
+    virtual void runImpl(ProgressType& progress) = 0;
+
+private:
+    // should be called under m_runLock
+    void runLocked()
+    {
+        if (requestRerun())
             return;
 
+        auto previousThread = m_runningThread.fetchAndStoreAcquire(QThread::currentThread());
+        SCOPE_EXIT {
+            m_runningThread.storeRelease(previousThread);
+        };
+
         // run later
         deferImpl([this] (ProgressType& progress, ThisType&) {
 
@@ -61,21 +84,40 @@ public:
         });
     }
 
-protected:
-    virtual void deferImpl(RunFnType&& func) = 0;
-    virtual void runImpl(ProgressType& progress) = 0;
+    // returns false if value is not in progress
+    bool requestRerun()
+    {
+        for (;;)
+        {
+            bool isRerunAccepted = false;
+            bool isInProgress = BaseType::accessProgress([&isRerunAccepted](ProgressType& progress) {
+                // if we are in progress already -> just request rerun
+                isRerunAccepted = progress.requestRerun();
+            });
+
+            if (!isInProgress || isRerunAccepted)
+                return isInProgress;
+
+            // calculation has made its last pass already -> wait it completes to run again
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    QMutex m_runLock;
+    // thread that starts progress under m_runLock
+    QAtomicPointer<QThread> m_runningThread;
 };
 
 
-template <typename ValueType_t, typename ErrorType_t = AsyncError, typename ProgressType_t = AsyncProgressRerun, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault>
-class AsyncValueRunableFn : public AsyncValueTemplate<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t>
+template <typename ValueType_t, typename ErrorType_t = AsyncError, typename ProgressType_t = AsyncProgressRerun, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault, typename TracePolicy_t = AsyncTracePolicyDefault, typename NotifyPolicy_t = AsyncNotifyPolicyDefault>
+class AsyncValueRunableFn : public AsyncValueTemplate<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>
 {
 public:
     using ValueType = ValueType_t;
     using ErrorType = ErrorType_t;
     using ProgressType = ProgressType_t;
-    using ThisType = AsyncValueRunableFn<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t>;
-    using BaseType = AsyncValueTemplate<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t>;
+    using ThisType = AsyncValueRunableFn<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>;
+    using BaseType = AsyncValueTemplate<ValueType_t, ErrorType_t, ProgressType_t, TrackErrorsPolicy_t, TracePolicy_t, NotifyPolicy_t>;
     using RunFnType = std::function<void(ProgressType&, ThisType&)>;
     using DeferFnType = std::function<void(const RunFnType&)>;
 
@@ -87,14 +129,30 @@ public:
 
     void run()
     {
-        bool isInProgress = BaseType::accessProgress([](ProgressType& progress) {
-            // if we are in progress already -> just request rerun
-            progress.requestRerun();
-        });
+        // nested run() from the thread that starts progress (slot connected to stateChanged)
+        if (m_runningThread.loadAcquire() == QThread::currentThread())
+        {
+            runLocked();
+            return;
+        }
+
+        // concurrent run() calls should check and start progress atomically
+        QMutexLocker locker(&m_runLock);
+        runLocked();
+    }
 
-        if (isInProgress)
+private:
+    // should be called under m_runLock
+    void runLocked()
+    {
+        if (requestRerun())
             return;
 
+        auto previousThread = m_runningThread.fetchAndStoreAcquire(QThread::currentThread());
+        SCOPE_EXIT {
+            m_runningThread.storeRelease(previousThread);
+        };
+
         // run later
         deferFn([this] (ProgressType& progress, ThisType& value) {
 
@@ -109,6 +167,29 @@ public:
 
         });
     }
+
+    // returns false if value is not in progress
+    bool requestRerun()
+    {
+        for (;;)
+        {
+            bool isRerunAccepted = false;
+            bool isInProgress = BaseType::accessProgress([&isRerunAccepted](ProgressType& progress) {
+                // if we are in progress already -> just request rerun
+                isRerunAccepted = progress.requestRerun();
+            });
+
+            if (!isInProgress || isRerunAccepted)
+                return isInProgress;
+
+            // calculation has made its last pass already -> wait it completes to run again
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    QMutex m_runLock;
+    // thread that starts progress under m_runLock
+    QAtomicPointer<QThread> m_runningThread;
 };
 
 #endif // ASYNC_VALUE_RUNABLE_H
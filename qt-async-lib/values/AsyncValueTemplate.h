@@ -20,6 +20,13 @@
 #include <memory>
 #include "AsyncValueBase.h"
 #include "AsyncTrackErrorsPolicy.h"
+#include "AsyncTracePolicy.h"
+#include "AsyncNotifyPolicy.h"
+#include "AsyncLockStats.h"
+#include "AsyncWatchdog.h"
+#include "AsyncMemoryResource.h"
+#include "AsyncReclaimer.h"
+#include "AsyncEviction.h"
 
 struct AsyncNoOp
 {
@@ -31,13 +38,14 @@ struct AsyncInitByValue {};
 struct AsyncInitByError {};
 
 
-template <typename ValueType_t, typename ErrorType_t, typename ProgressType_t, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault>
+template <typename ValueType_t, typename ErrorType_t, typename ProgressType_t, typename TrackErrorsPolicy_t = AsyncTrackErrorsPolicyDefault, typename TracePolicy_t = AsyncTracePolicyDefault, typename NotifyPolicy_t = AsyncNotifyPolicyDefault>
 class AsyncValueTemplate : public AsyncValueBase
 {
 public:
     using ValueType = ValueType_t;
     using ErrorType = ErrorType_t;
     using ProgressType = ProgressType_t;
+    using NotifyPolicy = NotifyPolicy_t;
 
     template <typename... Args>
     explicit AsyncValueTemplate(QObject* parent, AsyncInitByValue, Args&& ...arguments)
@@ -62,34 +70,37 @@ public:
     template <typename... Args>
     void emplaceValue(Args&& ...arguments)
     {
-        moveValue(std::make_unique<ValueType>(std::forward<Args>(arguments)...));
+        moveValue(asyncMakeUnique<ValueType>(m_memoryResource, std::forward<Args>(arguments)...));
     }
 
-    void moveValue(std::unique_ptr<ValueType> value)
+    void moveValue(AsyncUniquePtr<ValueType> value)
     {
         m_trackErrors.trackEmitDeadlock();
 
-        Content oldContent;
+        RetiredContent oldContent(m_reclaimer.loadAcquire());
 
-        QMutexLocker writeLocker(&m_writeLock);
+        AsyncMutexLocker writeLocker(&m_writeLock, asyncLockStats<ValueType, ASYNC_LOCK::WRITE>());
         {
-            QWriteLocker locker(&m_contentLock);
+            AsyncWriteLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
 
-            oldContent = std::move(m_content);
+            oldContent.content = std::move(m_content);
             m_content.value = std::move(value);
+            incrementVersion();
+            m_trace.value(this);
 
             // don't change state until stopProgress happen
             if (m_state == ASYNC_VALUE_STATE::PROGRESS)
                 return;
 
-            m_state = ASYNC_VALUE_STATE::VALUE;
+            setState(ASYNC_VALUE_STATE::VALUE);
+            beginPublish();
         }
 
         emitStateChanged();
 
-        // notify all waiters
-        if (m_waiter)
-            m_waiter->waitValue.wakeAll();
+        // notify all waiters, the value may be destroyed right after
+        writeLocker.unlock();
+        endPublish();
     }
 
     template <typename... Args>
@@ -109,45 +120,48 @@ public:
     template <typename... Args>
     void emplaceError(Args&& ...arguments)
     {
-        moveError(std::make_unique<ErrorType>(std::forward<Args>(arguments)...));
+        moveError(asyncMakeUnique<ErrorType>(m_memoryResource, std::forward<Args>(arguments)...));
     }
 
-    void moveError(std::unique_ptr<ErrorType> error)
+    void moveError(AsyncUniquePtr<ErrorType> error)
     {
         m_trackErrors.trackEmitDeadlock();
 
-        Content oldContent;
+        RetiredContent oldContent(m_reclaimer.loadAcquire());
 
-        QMutexLocker writeLocker(&m_writeLock);
+        AsyncMutexLocker writeLocker(&m_writeLock, asyncLockStats<ValueType, ASYNC_LOCK::WRITE>());
         {
-            QWriteLocker locker(&m_contentLock);
+            AsyncWriteLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
 
-            oldContent = std::move(m_content);
+            oldContent.content = std::move(m_content);
             m_content.error = std::move(error);
+            incrementVersion();
+            m_trace.error(this);
 
             // don't change state until stopProgress happen
             if (m_state == ASYNC_VALUE_STATE::PROGRESS)
                 return;
 
-            m_state = ASYNC_VALUE_STATE::ERROR;
+            setState(ASYNC_VALUE_STATE::ERROR);
+            beginPublish();
         }
 
         emitStateChanged();
 
-        // notify all waiters
-        if (m_waiter)
-            m_waiter->waitValue.wakeAll();
+        // notify all waiters, the value may be destroyed right after
+        writeLocker.unlock();
+        endPublish();
     }
 
-    bool startProgress(std::unique_ptr<ProgressType> progress)
+    bool startProgress(AsyncUniquePtr<ProgressType> progress)
     {
         Q_ASSERT(progress);
 
         m_trackErrors.trackEmitDeadlock();
 
-        Content oldContent;
+        RetiredContent oldContent(m_reclaimer.loadAcquire());
 
-        QMutexLocker writeLocker(&m_writeLock);
+        AsyncMutexLocker writeLocker(&m_writeLock, asyncLockStats<ValueType, ASYNC_LOCK::WRITE>());
 
         if (m_state == ASYNC_VALUE_STATE::PROGRESS)
         {
@@ -156,11 +170,15 @@ public:
         }
 
         {
-            QWriteLocker locker(&m_contentLock);
+            AsyncWriteLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
 
-            oldContent = std::move(m_content);
+            // previous value or error stays accessible while refreshing
+            if (!m_staleWhileRefresh.loadAcquire())
+                oldContent.content = std::move(m_content);
             m_progress = std::move(progress);
-            m_state = ASYNC_VALUE_STATE::PROGRESS;
+            setState(ASYNC_VALUE_STATE::PROGRESS);
+            incrementVersion();
+            m_trace.queued(this, *m_progress);
 
 #ifdef QT_DEBUG
             Q_ASSERT(!m_progress->isInUse() && "Progress is used already");
@@ -181,7 +199,7 @@ public:
         progress->setInUse(false);
 #endif
 
-        QMutexLocker writeLocker(&m_writeLock);
+        AsyncMutexLocker writeLocker(&m_writeLock, asyncLockStats<ValueType, ASYNC_LOCK::WRITE>());
 
         if (progress != m_progress.get())
         {
@@ -190,12 +208,12 @@ public:
         }
 
         {
-            QWriteLocker locker(&m_contentLock);
+            AsyncWriteLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
 
             if (m_content.value)
-                m_state = ASYNC_VALUE_STATE::VALUE;
+                setState(ASYNC_VALUE_STATE::VALUE);
             else if (m_content.error)
-                m_state = ASYNC_VALUE_STATE::ERROR;
+                setState(ASYNC_VALUE_STATE::ERROR);
             else
             {
                 m_trackErrors.incompleteProgress();
@@ -203,13 +221,16 @@ public:
             }
 
             m_progress = nullptr;
+            incrementVersion();
+            m_trace.completed(this);
+            beginPublish();
         }
 
         emitStateChanged();
 
-        // notify all waiters
-        if (m_waiter)
-            m_waiter->waitValue.wakeAll();
+        // notify all waiters, the value may be destroyed right after
+        writeLocker.unlock();
+        endPublish();
 
         return true;
     }
@@ -217,28 +238,33 @@ public:
     template <typename ValuePred, typename ErrorPred, typename ProgressPred>
     void access(ValuePred valuePred, ErrorPred errorPred, ProgressPred progressPred)
     {
-        QReadLocker locker(&m_contentLock);
+        AsyncReadLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
 
-        switch (m_state)
-        {
-        case ASYNC_VALUE_STATE::VALUE:
-            valuePred(*m_content.value);
-            break;
+        accessLocked(valuePred, errorPred, progressPred);
+    }
 
-        case ASYNC_VALUE_STATE::ERROR:
-            errorPred(*m_content.error);
-            break;
+    // returns false without locking if value hasn't changed since the version
+    // otherwise accesses the value and updates the version
+    template <typename ValuePred, typename ErrorPred, typename ProgressPred>
+    bool accessIfChangedSince(quint64& version, ValuePred valuePred, ErrorPred errorPred, ProgressPred progressPred)
+    {
+        if (m_version.loadAcquire() == version)
+            return false;
 
-        case ASYNC_VALUE_STATE::PROGRESS:
-            progressPred(*m_progress);
-            break;
-        }
+        AsyncReadLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
+
+        version = m_version.loadAcquire();
+        accessLocked(valuePred, errorPred, progressPred);
+        return true;
     }
 
     template <typename ValuePred, typename ErrorPred>
     bool access(ValuePred valuePred, ErrorPred errorPred)
     {
-        QReadLocker locker(&m_contentLock);
+        AsyncReadLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
 
         switch (m_state)
         {
@@ -258,7 +284,8 @@ public:
     template <typename Pred>
     bool access(Pred valuePred)
     {
-        QReadLocker locker(&m_contentLock);
+        AsyncReadLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
 
         if (m_state != ASYNC_VALUE_STATE::VALUE)
             return false;
@@ -276,7 +303,8 @@ public:
     template <typename Pred>
     bool accessError(Pred errorPred)
     {
-        QReadLocker locker(&m_contentLock);
+        AsyncReadLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
 
         if (m_state != ASYNC_VALUE_STATE::ERROR)
             return false;
@@ -288,7 +316,8 @@ public:
     template <typename Pred>
     bool accessProgress(Pred progressPred)
     {
-        QReadLocker locker(&m_contentLock);
+        AsyncReadLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
 
         if (m_state != ASYNC_VALUE_STATE::PROGRESS)
             return false;
@@ -297,71 +326,60 @@ public:
         return true;
      }
 
+    // like access(valuePred, errorPred) but while refreshing accesses previous value or error
     template <typename ValuePred, typename ErrorPred>
-    void wait(ValuePred valuePred, ErrorPred errorPred)
+    bool accessStale(ValuePred valuePred, ErrorPred errorPred)
     {
-        // easy case we have value or error
-        if (access(valuePred, errorPred))
-            return;
+        AsyncReadLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "access");
 
-        // lock async value
-        QMutexLocker writeLocker(&m_writeLock);
-        // check easy case again
-        if (access(valuePred, errorPred))
-            return;
+        if (m_content.value)
+            valuePred(*m_content.value);
+        else if (m_content.error)
+            errorPred(*m_content.error);
+        else
+            return false;
 
-        // if we are the first waiters
-        // create Waiter on stack and assign it to m_waiter
-        // all subsequent waiters will use this one
-        if (!m_waiter)
-        {
-            Waiter theWaiter;
-
-            SCOPE_EXIT {
-                if (m_waiter->subWaiters > 0)
-                {
-                    do
-                    {
-                        // repeatedly wait for all sub waiters
-                        // because of spurious wakeups
-                        m_waiter->waitSubWaiters.wait(&m_writeLock);
-                    } while (m_waiter->subWaiters != 0);
-                }
-
-                // unregister self as main waiter
-                m_waiter = nullptr;
-            };
-
-            // register self as main waiter
-            m_waiter = &theWaiter;
+        return true;
+    }
 
-            do
-            {
-                // repeatedly wait for value or error
-                // because of spurious wakeups
-                m_waiter->waitValue.wait(&m_writeLock);
-            } while (!access(valuePred, errorPred));
-        }
-        else
-        {
-            SCOPE_EXIT {
-                // unregister self as subwaiter
-                m_waiter->subWaiters -= 1;
-                // if no subwaiters -> notify main waiter to release
-                if (m_waiter->subWaiters == 0)
-                    m_waiter->waitSubWaiters.wakeAll();
-            };
+    // if enabled, startProgress keeps previous value or error (stale-while-revalidate)
+    // progress that completes without new value or error restores the previous one
+    bool isStaleWhileRefresh() const
+    {
+        return m_staleWhileRefresh.loadAcquire();
+    }
 
-            // register self as subwaiter
-            m_waiter->subWaiters += 1;
+    void setStaleWhileRefresh(bool enable)
+    {
+        m_staleWhileRefresh.storeRelease(enable ? 1 : 0);
+    }
+
+    // returns true if value is in progress and keeps previous value or error
+    bool isRefreshing()
+    {
+        AsyncReadLocker locker(&m_contentLock, asyncLockStats<ValueType, ASYNC_LOCK::CONTENT>());
+        return m_state == ASYNC_VALUE_STATE::PROGRESS && (m_content.value || m_content.error);
+    }
+
+    template <typename ValuePred, typename ErrorPred>
+    void wait(ValuePred valuePred, ErrorPred errorPred)
+    {
+        // easy case we have value or error
+        if (!access(valuePred, errorPred))
+        {
+            AsyncWatchdogScope watchdogScope(ASYNC_STALL::WAIT, this, typeid(ValueType), "wait");
 
             do
             {
-                // repeatedly wait for value or error
-                // because of spurious wakeups
-                m_waiter->waitValue.wait(&m_writeLock);
+                // waiters don't take m_writeLock and don't depend on each other,
+                // value may return to progress state before access
+                waitNoProgress();
             } while (!access(valuePred, errorPred));
         }
+
+        // producer may still notify, so caller can't destroy the value yet
+        waitPublished();
     }
 
     void wait()
@@ -369,6 +387,55 @@ public:
         wait(AsyncNoOp(), AsyncNoOp());
     }
 
+    // resource to allocate value, error and progress from (nullptr means new/delete)
+    AsyncMemoryResource* memoryResource() const
+    {
+        return m_memoryResource;
+    }
+
+    // reclaimer to destroy replaced value or error in background (nullptr means destroy in place)
+    AsyncReclaimer* reclaimer() const
+    {
+        return m_reclaimer.loadAcquire();
+    }
+
+    // values allocated from memory resource refuse reclaimer and return false:
+    // resource (like AsyncMonotonicResource arena) may be released while reclaimer still holds the content
+    bool setReclaimer(AsyncReclaimer* reclaimer)
+    {
+        if (reclaimer && m_memoryResource)
+        {
+            m_trackErrors.reclaimerWithMemoryResource();
+            return false;
+        }
+
+        m_reclaimer.storeRelease(reclaimer);
+        return true;
+    }
+
+    // available for AsyncNotifyPolicyCallbacks values
+    // callback is called in the thread that changes the value
+    void subscribe(AsyncStateCallback* callback)
+    {
+        m_trackErrors.trackEmitDeadlock();
+        AsyncMutexLocker writeLocker(&m_writeLock, asyncLockStats<ValueType, ASYNC_LOCK::WRITE>());
+        m_notify.subscribe(callback);
+    }
+
+    // waits until callback returns if it's being called right now
+    void unsubscribe(AsyncStateCallback* callback)
+    {
+        m_trackErrors.trackEmitDeadlock();
+        AsyncMutexLocker writeLocker(&m_writeLock, asyncLockStats<ValueType, ASYNC_LOCK::WRITE>());
+        m_notify.unsubscribe(callback);
+    }
+
+    // called by asyncValueRunXXX functions when calculation starts
+    void traceStarted()
+    {
+        m_trace.started(this);
+    }
+
     void stopAndWait()
     {
         accessProgress([](ProgressType& progress){
@@ -378,24 +445,85 @@ public:
     }
 
 private:
+    template <typename ValuePred, typename ErrorPred, typename ProgressPred>
+    void accessLocked(ValuePred& valuePred, ErrorPred& errorPred, ProgressPred& progressPred)
+    {
+        switch (m_state)
+        {
+        case ASYNC_VALUE_STATE::VALUE:
+            valuePred(*m_content.value);
+            break;
+
+        case ASYNC_VALUE_STATE::ERROR:
+            errorPred(*m_content.error);
+            break;
+
+        case ASYNC_VALUE_STATE::PROGRESS:
+            progressPred(*m_progress);
+            break;
+        }
+    }
+
     void emitStateChanged()
     {
+        // nobody listens, skip notification bookkeeping
+        if (!m_notify.hasListeners(*this))
+            return;
+
         using EmitGuardType = typename TrackErrorsPolicy_t::EmitGuardType;
         EmitGuardType emitGuard(m_trackErrors);
+        AsyncWatchdogScope watchdogScope(ASYNC_STALL::LOCK_HOLD, this, typeid(ValueType), "stateChanged");
+
+        m_notify.notify(*this, m_state);
 
-        emit stateChanged(m_state);
+        m_trace.notified(this);
     }
 
     struct Content
     {
-        std::unique_ptr<ValueType> value;
-        std::unique_ptr<ErrorType> error;
+        AsyncUniquePtr<ValueType> value;
+        AsyncUniquePtr<ErrorType> error;
     };
     Content m_content;
 
-    std::unique_ptr<ProgressType> m_progress;
+    // replaced content is destroyed after all locks are released
+    // or handed to the reclaimer
+    struct RetiredContent
+    {
+        explicit RetiredContent(AsyncReclaimer* reclaimer)
+            : reclaimer(reclaimer)
+        {
+        }
+
+        ~RetiredContent()
+        {
+            if (!reclaimer || (!content.value && !content.error))
+                return;
+
+            qint64 bytes = 0;
+            if (content.value)
+                bytes += asyncValueByteSize(*content.value);
+            if (content.error)
+                bytes += asyncValueByteSize(*content.error);
+
+            reclaimer->retire(std::move(content), bytes);
+        }
+
+        AsyncReclaimer* const reclaimer;
+        Content content;
+    };
+
+    AsyncUniquePtr<ProgressType> m_progress;
+
+    QAtomicInt m_staleWhileRefresh;
+    QAtomicPointer<AsyncReclaimer> m_reclaimer;
+
+    // thread default resource at construction time
+    AsyncMemoryResource* const m_memoryResource = AsyncMemoryResource::threadDefault();
 
     TrackErrorsPolicy_t m_trackErrors;
+    TracePolicy_t m_trace;
+    NotifyPolicy_t m_notify;
 };
 
 #endif // ASYNC_VALUE_TEMPLATE_H
@@ -0,0 +1,257 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncWatchdog.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <memory>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+QAtomicInt AsyncWatchdog::m_running(0);
+
+namespace
+{
+
+QString typeName(const std::type_info& type)
+{
+#ifdef __GNUG__
+    int status = 0;
+    std::unique_ptr<char, void(*)(void*)> demangled(abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+    if (status == 0 && demangled)
+        return QString::fromLatin1(demangled.get());
+#endif
+    return QString::fromLatin1(type.name());
+}
+
+struct Operation
+{
+    ASYNC_STALL kind;
+    const void* value;
+    const std::type_info* valueType;
+    QString site;
+    Qt::HANDLE thread;
+    qint64 startTime;
+    bool reported;
+};
+
+class WatchdogThread : public QThread
+{
+public:
+    void run() override;
+};
+
+struct WatchdogData
+{
+    WatchdogData()
+    {
+        clock.start();
+    }
+
+    QMutex lock;
+    QWaitCondition wakeUp;
+    QElapsedTimer clock;
+
+    QHash<quint64, Operation> operations;
+    quint64 nextToken = 1;
+
+    AsyncWatchdogThresholds thresholds;
+    AsyncWatchdog::Reporter reporter;
+    std::unique_ptr<WatchdogThread> thread;
+    bool stopRequested = false;
+};
+
+Q_GLOBAL_STATIC(WatchdogData, watchdogData)
+
+qint64 threshold(const AsyncWatchdogThresholds& thresholds, ASYNC_STALL kind)
+{
+    switch (kind)
+    {
+    case ASYNC_STALL::PROGRESS: return thresholds.progressMs;
+    case ASYNC_STALL::WAIT: return thresholds.waitMs;
+    case ASYNC_STALL::LOCK_HOLD: return thresholds.lockHoldMs;
+    }
+
+    return thresholds.progressMs;
+}
+
+void WatchdogThread::run()
+{
+    auto data = watchdogData();
+
+    for (;;)
+    {
+        QVector<AsyncStall> stalls;
+        AsyncWatchdog::Reporter reporter;
+
+        {
+            QMutexLocker locker(&data->lock);
+
+            if (data->stopRequested)
+                return;
+
+            data->wakeUp.wait(&data->lock, static_cast<unsigned long>(data->thresholds.checkIntervalMs));
+
+            if (data->stopRequested)
+                return;
+
+            const auto now = data->clock.elapsed();
+            for (auto& operation : data->operations)
+            {
+                if (operation.reported)
+                    continue;
+
+                auto stuckMs = now - operation.startTime;
+                if (stuckMs < threshold(data->thresholds, operation.kind))
+                    continue;
+
+                // report every stall once
+                operation.reported = true;
+                stalls.append(AsyncStall{operation.kind, operation.value, typeName(*operation.valueType), operation.site, operation.thread, stuckMs});
+            }
+
+            reporter = data->reporter;
+        }
+
+        // report without lock so reporter may use async values
+        for (const auto& stall : stalls)
+        {
+            if (reporter)
+                reporter(stall);
+            else
+                qWarning().noquote() << AsyncWatchdog::toString(stall);
+        }
+    }
+}
+
+} // end anonymous namespace
+
+void AsyncWatchdog::start(const AsyncWatchdogThresholds& thresholds)
+{
+    auto data = watchdogData();
+
+    {
+        QMutexLocker locker(&data->lock);
+
+        data->thresholds = thresholds;
+
+        if (data->thread)
+        {
+            // apply new thresholds
+            data->wakeUp.wakeAll();
+            return;
+        }
+
+        data->stopRequested = false;
+        data->thread = std::make_unique<WatchdogThread>();
+        data->thread->setObjectName("AsyncWatchdog");
+    }
+
+    data->thread->start(QThread::LowPriority);
+    m_running.storeRelease(1);
+}
+
+void AsyncWatchdog::stop()
+{
+    auto data = watchdogData();
+
+    m_running.storeRelease(0);
+
+    std::unique_ptr<WatchdogThread> thread;
+    {
+        QMutexLocker locker(&data->lock);
+        data->stopRequested = true;
+        data->wakeUp.wakeAll();
+        thread = std::move(data->thread);
+        data->operations.clear();
+    }
+
+    if (thread)
+        thread->wait();
+}
+
+void AsyncWatchdog::setReporter(Reporter reporter)
+{
+    auto data = watchdogData();
+    QMutexLocker locker(&data->lock);
+    data->reporter = std::move(reporter);
+}
+
+QString AsyncWatchdog::toString(const AsyncStall& stall)
+{
+    QString what;
+    switch (stall.kind)
+    {
+    case ASYNC_STALL::PROGRESS:
+        what = "is in progress";
+        break;
+
+    case ASYNC_STALL::WAIT:
+        what = "is waited";
+        break;
+
+    case ASYNC_STALL::LOCK_HOLD:
+        what = "is locked";
+        break;
+    }
+
+    return QString("AsyncWatchdog: value 0x%1 (%2) %3 for %4 ms by %5 in thread 0x%6")
+            .arg(reinterpret_cast<quintptr>(stall.value), 0, 16)
+            .arg(stall.valueType)
+            .arg(what)
+            .arg(stall.stuckMs)
+            .arg(stall.site)
+            .arg(reinterpret_cast<quintptr>(stall.thread), 0, 16);
+}
+
+quint64 AsyncWatchdog::begin(ASYNC_STALL kind, const void* value, const std::type_info& valueType, QString site)
+{
+    auto data = watchdogData();
+    QMutexLocker locker(&data->lock);
+
+    if (!isRunning())
+        return 0;
+
+    auto token = data->nextToken++;
+    data->operations.insert(token, Operation{kind, value, &valueType, std::move(site), QThread::currentThreadId(), data->clock.elapsed(), false});
+    return token;
+}
+
+void AsyncWatchdog::end(quint64 token)
+{
+    if (!token)
+        return;
+
+    auto data = watchdogData();
+    QMutexLocker locker(&data->lock);
+    data->operations.remove(token);
+}
+
+QString AsyncWatchdog::runSite(const std::type_info& func, const QString& message)
+{
+    if (message.isEmpty())
+        return typeName(func);
+
+    return QString("%1 \"%2\"").arg(typeName(func), message);
+}
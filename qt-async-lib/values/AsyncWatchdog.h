@@ -0,0 +1,114 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_WATCHDOG_H
+#define ASYNC_WATCHDOG_H
+
+#include "../Config.h"
+#include <QAtomicInt>
+#include <QString>
+#include <functional>
+#include <typeinfo>
+
+enum class ASYNC_STALL
+{
+    // value stays in progress state (run never calls completeProgress)
+    PROGRESS,
+    // wait() doesn't return
+    WAIT,
+    // lock is held by access callback or stateChanged handler
+    LOCK_HOLD
+};
+
+struct AsyncWatchdogThresholds
+{
+    int progressMs = ASYNC_WATCHDOG_PROGRESS_THRESHOLD;
+    int waitMs = ASYNC_WATCHDOG_WAIT_THRESHOLD;
+    int lockHoldMs = ASYNC_WATCHDOG_LOCK_HOLD_THRESHOLD;
+    // how often the watchdog thread checks registered operations
+    int checkIntervalMs = ASYNC_WATCHDOG_CHECK_INTERVAL;
+};
+
+struct AsyncStall
+{
+    ASYNC_STALL kind;
+    // async value address
+    const void* value;
+    // demangled name of the value type
+    QString valueType;
+    // run function type and progress message for runs, operation name otherwise
+    QString site;
+    // thread that registered the operation
+    Qt::HANDLE thread;
+    qint64 stuckMs;
+};
+
+// background thread that reports async operations running longer than thresholds
+// watchdog is off by default, registration costs one atomic load until it is started
+class AsyncWatchdog
+{
+public:
+    using Reporter = std::function<void(const AsyncStall&)>;
+
+    static void start(const AsyncWatchdogThresholds& thresholds = AsyncWatchdogThresholds());
+    static void stop();
+    static bool isRunning() { return m_running.loadAcquire() != 0; }
+
+    // by default stalls are reported by qWarning
+    static void setReporter(Reporter reporter);
+    static QString toString(const AsyncStall& stall);
+
+    // registers operation, returns 0 if watchdog is not running
+    static quint64 begin(ASYNC_STALL kind, const void* value, const std::type_info& valueType, QString site);
+    static void end(quint64 token);
+
+    template <typename AsyncValueType, typename Func>
+    static quint64 beginRun(const AsyncValueType& value, const Func&, const typename AsyncValueType::ProgressType& progress)
+    {
+        if (!isRunning())
+            return 0;
+
+        return begin(ASYNC_STALL::PROGRESS, &value, typeid(typename AsyncValueType::ValueType), runSite(typeid(Func), progress.message()));
+    }
+
+private:
+    static QString runSite(const std::type_info& func, const QString& message);
+
+    static QAtomicInt m_running;
+};
+
+// registers operation for the scope lifetime
+class AsyncWatchdogScope
+{
+    Q_DISABLE_COPY(AsyncWatchdogScope)
+
+public:
+    AsyncWatchdogScope(ASYNC_STALL kind, const void* value, const std::type_info& valueType, const char* site)
+        : m_token(AsyncWatchdog::isRunning() ? AsyncWatchdog::begin(kind, value, valueType, QString::fromLatin1(site)) : 0)
+    {
+    }
+
+    ~AsyncWatchdogScope()
+    {
+        if (m_token)
+            AsyncWatchdog::end(m_token);
+    }
+
+private:
+    const quint64 m_token;
+};
+
+#endif // ASYNC_WATCHDOG_H
@@ -0,0 +1,108 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncItemDelegate.h"
+#include "AsyncItemModelBase.h"
+#include <QApplication>
+#include <QPainter>
+#include <QStyleOption>
+
+AsyncItemDelegate::AsyncItemDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void AsyncItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    auto state = index.data(AsyncItemModelBase::StateRole);
+    if (!state.isValid())
+    {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    switch (state.value<ASYNC_VALUE_STATE>())
+    {
+    case ASYNC_VALUE_STATE::VALUE:
+        QStyledItemDelegate::paint(painter, option, index);
+        break;
+
+    case ASYNC_VALUE_STATE::ERROR:
+        paintError(painter, option, index);
+        break;
+
+    case ASYNC_VALUE_STATE::PROGRESS:
+        paintProgress(painter, option, index);
+        break;
+    }
+}
+
+QSize AsyncItemDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    auto size = QStyledItemDelegate::sizeHint(option, index);
+
+    // reserve space for message and progress bar
+    if (index.data(AsyncItemModelBase::StateRole).value<ASYNC_VALUE_STATE>() == ASYNC_VALUE_STATE::PROGRESS)
+        size.setHeight(qMax(size.height(), option.fontMetrics.height() * 2 + 6));
+
+    return size;
+}
+
+void AsyncItemDelegate::paintError(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+
+    opt.displayAlignment = Qt::AlignCenter;
+    opt.features |= QStyleOptionViewItem::WrapText;
+    opt.palette.setColor(QPalette::Text, Qt::darkRed);
+
+    auto widget = opt.widget;
+    auto style = widget ? widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+}
+
+void AsyncItemDelegate::paintProgress(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    auto widget = option.widget;
+    auto style = widget ? widget->style() : QApplication::style();
+
+    // draw selection and background
+    {
+        QStyleOptionViewItem opt = option;
+        initStyleOption(&opt, index);
+        opt.text.clear();
+        opt.icon = QIcon();
+        style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+    }
+
+    QStyleOptionProgressBar progressOpt;
+    progressOpt.state = option.state;
+    progressOpt.direction = option.direction;
+    progressOpt.palette = option.palette;
+    progressOpt.fontMetrics = option.fontMetrics;
+    progressOpt.rect = option.rect.adjusted(3, 3, -3, -3);
+    progressOpt.minimum = 0;
+    progressOpt.maximum = 100;
+    progressOpt.progress = static_cast<int>(index.data(AsyncItemModelBase::ProgressRole).toFloat() * 100.f);
+    progressOpt.text = index.data(AsyncItemModelBase::ProgressMessageRole).toString();
+    if (index.data(AsyncItemModelBase::StopRequestedRole).toBool())
+        progressOpt.text += "(Stopping...)";
+    progressOpt.textVisible = !progressOpt.text.isEmpty();
+    progressOpt.textAlignment = Qt::AlignCenter;
+
+    style->drawControl(QStyle::CE_ProgressBar, &progressOpt, painter, widget);
+}
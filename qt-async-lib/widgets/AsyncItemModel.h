@@ -0,0 +1,194 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_ITEM_MODEL_H
+#define ASYNC_ITEM_MODEL_H
+
+#include <functional>
+#include "AsyncItemModelBase.h"
+#include "values/AsyncNotifyPolicy.h"
+
+template <typename AsyncValueType>
+class AsyncItemModel : public AsyncItemModelBase
+{
+    static_assert(AsyncValueEmitsStateChanged<AsyncValueType>::value, "Model updates rows by stateChanged signal, use AsyncNotifyPolicySignal");
+
+public:
+    using ValueType = typename AsyncValueType::ValueType;
+    using ErrorType = typename AsyncValueType::ErrorType;
+    using ProgressType = typename AsyncValueType::ProgressType;
+
+    using AsyncItemModelBase::AsyncItemModelBase;
+
+    // async values should outlive the model or be removed from it before destruction
+    void setValues(QVector<AsyncValueType*> asyncValues)
+    {
+        beginResetModel();
+
+        for (auto asyncValue : m_asyncValues)
+            QObject::disconnect(asyncValue, &AsyncValueBase::stateChanged, this, nullptr);
+
+        m_asyncValues = std::move(asyncValues);
+        clearRows(m_asyncValues.size());
+        auto generation = rowsGeneration();
+
+        for (int row = 0; row < m_asyncValues.size(); ++row)
+        {
+            auto asyncValue = m_asyncValues[row];
+            Q_ASSERT(asyncValue);
+
+            // stateChanged may be emitted from any thread
+            // so use this as a context object to handle it in GUI thread,
+            // notifications already queued for previous values are dropped by generation
+            QObject::connect(asyncValue, &AsyncValueBase::stateChanged, this, [this, row, generation](ASYNC_VALUE_STATE state) {
+                onRowStateChanged(row, generation, state);
+            });
+
+            asyncValue->accessProgress([this, row, generation](ProgressType&) {
+                onRowStateChanged(row, generation, ASYNC_VALUE_STATE::PROGRESS);
+            });
+        }
+
+        endResetModel();
+    }
+
+    AsyncValueType* asyncValue(const QModelIndex& index) const
+    {
+        if (!index.isValid() || index.row() >= m_asyncValues.size())
+            return nullptr;
+
+        return m_asyncValues[index.row()];
+    }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_asyncValues.size();
+    }
+
+    QVariant data(const QModelIndex& index, int role) const override
+    {
+        auto asyncValue = this->asyncValue(index);
+        if (!asyncValue)
+            return QVariant();
+
+        QVariant result;
+
+        asyncValue->access([&result, role, this](ValueType& value){
+            if (role == StateRole)
+                result = QVariant::fromValue(ASYNC_VALUE_STATE::VALUE);
+            else
+                result = valueDataImpl(value, role);
+        }, [&result, role, this](ErrorType& error){
+            if (role == StateRole)
+                result = QVariant::fromValue(ASYNC_VALUE_STATE::ERROR);
+            else
+                result = errorDataImpl(error, role);
+        }, [&result, role, this](ProgressType& progress){
+            if (role == StateRole)
+                result = QVariant::fromValue(ASYNC_VALUE_STATE::PROGRESS);
+            else
+                result = progressDataImpl(progress, role);
+        });
+
+        return result;
+    }
+
+protected:
+    // all *DataImpl functions are called while async value is locked
+    // so they should be fast and shouldn't modify async value
+    virtual QVariant valueDataImpl(ValueType& /*value*/, int role) const
+    {
+        if (role == Qt::DisplayRole)
+            return QString("<value data is not implemented>");
+
+        return QVariant();
+    }
+
+    virtual QVariant errorDataImpl(ErrorType& error, int role) const
+    {
+        if (role == Qt::DisplayRole || role == Qt::ToolTipRole)
+            return error.text();
+
+        return QVariant();
+    }
+
+    virtual QVariant progressDataImpl(ProgressType& progress, int role) const
+    {
+        switch (role)
+        {
+        case Qt::DisplayRole:
+        case ProgressMessageRole:
+            return progress.message();
+
+        case ProgressRole:
+            return progress.progress();
+
+        case CanRequestStopRole:
+            return progress.canRequestStop();
+
+        case StopRequestedRole:
+            return progress.isStopRequested();
+
+        default:
+            return QVariant();
+        }
+    }
+
+private:
+    QVector<AsyncValueType*> m_asyncValues;
+};
+
+template <typename AsyncValueType>
+class AsyncItemModelFn : public AsyncItemModel<AsyncValueType>
+{
+public:
+    using ValueType = typename AsyncValueType::ValueType;
+    using ErrorType = typename AsyncValueType::ErrorType;
+    using ProgressType = typename AsyncValueType::ProgressType;
+
+    using AsyncItemModel<AsyncValueType>::AsyncItemModel;
+
+    std::function<QVariant(ValueType&, int)> valueData;
+    std::function<QVariant(ErrorType&, int)> errorData;
+    std::function<QVariant(ProgressType&, int)> progressData;
+
+protected:
+    QVariant valueDataImpl(ValueType& value, int role) const override
+    {
+        if (valueData)
+            return valueData(value, role);
+        else
+            return AsyncItemModel<AsyncValueType>::valueDataImpl(value, role);
+    }
+
+    QVariant errorDataImpl(ErrorType& error, int role) const override
+    {
+        if (errorData)
+            return errorData(error, role);
+        else
+            return AsyncItemModel<AsyncValueType>::errorDataImpl(error, role);
+    }
+
+    QVariant progressDataImpl(ProgressType& progress, int role) const override
+    {
+        if (progressData)
+            return progressData(progress, role);
+        else
+            return AsyncItemModel<AsyncValueType>::progressDataImpl(progress, role);
+    }
+};
+
+#endif // ASYNC_ITEM_MODEL_H
@@ -0,0 +1,109 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AsyncItemModelBase.h"
+#include "../Config.h"
+#include <QTimer>
+#include <algorithm>
+
+AsyncItemModelBase::AsyncItemModelBase(QObject* parent)
+    : QAbstractListModel(parent)
+{
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(ASYNC_ITEM_MODEL_UPDATE_TIMEOUT);
+    connect(m_flushTimer, &QTimer::timeout, this, &AsyncItemModelBase::flushChangedRows);
+
+    m_progressTimer = new QTimer(this);
+    m_progressTimer->setInterval(ASYNC_PROGRESS_WIDGET_UPDATE_TIMEOUT);
+    connect(m_progressTimer, &QTimer::timeout, this, [this]() {
+        QVector<int> rows;
+        rows.reserve(m_progressRowsCount);
+        for (int row = 0; row < m_progressRows.size(); ++row)
+        {
+            if (m_progressRows[row])
+                rows.append(row);
+        }
+
+        // only progress data changes while row stays in progress
+        static const QVector<int> progressRoles = {Qt::DisplayRole, ProgressRole, ProgressMessageRole, StopRequestedRole};
+        emitRowsChanged(rows, progressRoles);
+    });
+}
+
+void AsyncItemModelBase::onRowStateChanged(int row, int generation, ASYNC_VALUE_STATE state)
+{
+    // queued notification from values of previous setValues
+    if (generation != m_rowsGeneration || row < 0 || row >= m_progressRows.size())
+        return;
+
+    bool inProgress = (state == ASYNC_VALUE_STATE::PROGRESS);
+    if (m_progressRows[row] != inProgress)
+    {
+        m_progressRows[row] = inProgress;
+        m_progressRowsCount += inProgress ? 1 : -1;
+
+        if (m_progressRowsCount == 0)
+            m_progressTimer->stop();
+        else if (!m_progressTimer->isActive())
+            m_progressTimer->start();
+    }
+
+    // collect changes and report them in a batch
+    m_changedRows.append(row);
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+void AsyncItemModelBase::clearRows(int rowCount)
+{
+    m_flushTimer->stop();
+    m_progressTimer->stop();
+
+    m_changedRows.clear();
+    m_progressRows.fill(false, rowCount);
+    m_progressRowsCount = 0;
+    ++m_rowsGeneration;
+}
+
+void AsyncItemModelBase::flushChangedRows()
+{
+    emitRowsChanged(m_changedRows);
+    m_changedRows.clear();
+}
+
+void AsyncItemModelBase::emitRowsChanged(QVector<int>& rows, const QVector<int>& roles)
+{
+    if (rows.isEmpty())
+        return;
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // emit one dataChanged per continuous range of rows
+    int first = rows.front();
+    int last = first;
+    for (int i = 1; i < rows.size(); ++i)
+    {
+        if (rows[i] != last + 1)
+        {
+            emit dataChanged(index(first), index(last), roles);
+            first = rows[i];
+        }
+        last = rows[i];
+    }
+    emit dataChanged(index(first), index(last), roles);
+}
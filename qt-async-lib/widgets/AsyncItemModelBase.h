@@ -0,0 +1,76 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_ITEM_MODEL_BASE_H
+#define ASYNC_ITEM_MODEL_BASE_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include "values/AsyncValueBase.h"
+
+class QTimer;
+
+class AsyncItemModelBase : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AsyncItemModelBase)
+
+public:
+    enum Role
+    {
+        // ASYNC_VALUE_STATE of the row
+        StateRole = Qt::UserRole + 1,
+        // progress position in [0, 1]
+        ProgressRole,
+        // progress message
+        ProgressMessageRole,
+        // true if progress can handle stop requests
+        CanRequestStopRole,
+        // true if progress was requested to stop
+        StopRequestedRole
+    };
+
+    explicit AsyncItemModelBase(QObject* parent = nullptr);
+
+protected:
+    // should be called in GUI thread only
+    // notifications queued before the last clearRows are ignored
+    void onRowStateChanged(int row, int generation, ASYNC_VALUE_STATE state);
+    // starts new rows generation
+    void clearRows(int rowCount);
+
+    int rowsGeneration() const
+    {
+        return m_rowsGeneration;
+    }
+
+private:
+    void flushChangedRows();
+    void emitRowsChanged(QVector<int>& rows, const QVector<int>& roles = QVector<int>());
+
+    // rows changed since last flush
+    QVector<int> m_changedRows;
+    // rows in progress state, they are refreshed periodically
+    QVector<bool> m_progressRows;
+    int m_progressRowsCount = 0;
+    // incremented by clearRows to drop notifications for old rows
+    int m_rowsGeneration = 0;
+
+    QTimer* m_flushTimer = nullptr;
+    QTimer* m_progressTimer = nullptr;
+};
+
+#endif // ASYNC_ITEM_MODEL_BASE_H
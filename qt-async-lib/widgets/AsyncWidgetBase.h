@@ -17,12 +17,25 @@
 #ifndef ASYNC_WIDGET_BASE_H
 #define ASYNC_WIDGET_BASE_H
 
+#include <type_traits>
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QTimer>
 #include "AsyncWidgetProxy.h"
-#include "values/AsyncValueBase.h"
+#include "values/AsyncNotifyPolicy.h"
+
+// detects async values with public run() function
+template <typename AsyncValueType, typename = void>
+struct AsyncValueIsRunable : std::false_type {};
+
+template <typename AsyncValueType>
+struct AsyncValueIsRunable<AsyncValueType, decltype(std::declval<AsyncValueType&>().run(), void())> : std::true_type {};
 
 template <typename AsyncValueType>
 class AsyncWidgetBase : public AsyncWidgetProxy
 {
+    static_assert(AsyncValueEmitsStateChanged<AsyncValueType>::value, "Widget updates content by stateChanged signal, use AsyncNotifyPolicySignal");
+
 public:
     using AsyncWidgetProxy::AsyncWidgetProxy;
 
@@ -34,11 +47,17 @@ public:
         if (m_asyncValue)
             QObject::disconnect(m_asyncValue, &AsyncValueBase::stateChanged, this, &AsyncWidgetBase::onValueStateChanged);
         setContentWidget(nullptr);
+        resetProgressTimers();
 
         m_asyncValue = asyncValue;
+        m_runOnVisiblePending = true;
+        m_stoppedWhileHidden = false;
         if (m_asyncValue)
             QObject::connect(m_asyncValue, &AsyncValueBase::stateChanged, this, &AsyncWidgetBase::onValueStateChanged);
         updateContent();
+
+        if (this->isRunOnVisible() && this->isExposed())
+            exposedImpl();
     }
 
 protected:
@@ -51,7 +70,68 @@ protected:
     virtual QWidget* createProgressWidgetImpl(ProgressType& progress, QWidget* parent) = 0;
     virtual QWidget* createNoAsyncValueWidgetImpl(QWidget* parent) { return createLabel("<no value>", parent); }
 
+    AsyncValueType* asyncValue() const { return m_asyncValue; }
+
+    void exposedImpl() override
+    {
+        if (!m_asyncValue)
+            return;
+
+        bool isInProgress = m_asyncValue->accessProgress([](ProgressType& progress) {
+            // restore thread priority
+            progress.setThreadPriority(QThread::InheritPriority);
+        });
+
+        // value is being calculated already
+        if (isInProgress && !m_stoppedWhileHidden)
+            m_runOnVisiblePending = false;
+
+        if (!m_runOnVisiblePending && !m_stoppedWhileHidden)
+            return;
+
+        m_runOnVisiblePending = false;
+        m_stoppedWhileHidden = false;
+
+        // if stopped calculation is not finished yet, run() will request rerun
+        runValue(AsyncValueIsRunable<AsyncValueType>());
+    }
+
+    void hiddenImpl() override
+    {
+        if (!m_asyncValue)
+            return;
+
+        m_asyncValue->accessProgress([](ProgressType& progress) {
+            // don't waste CPU while nobody sees the result
+            progress.setThreadPriority(QThread::LowestPriority);
+        });
+    }
+
+    void hiddenTimeoutImpl() override
+    {
+        if (!m_asyncValue)
+            return;
+
+        bool isInProgress = m_asyncValue->accessProgress([](ProgressType& progress) {
+            progress.requestStop();
+        });
+
+        // rerun stopped value when widget becomes visible again
+        if (isInProgress)
+            m_stoppedWhileHidden = true;
+    }
+
 private:
+    void runValue(std::true_type)
+    {
+        m_asyncValue->run();
+    }
+
+    void runValue(std::false_type)
+    {
+        // async value is not runable
+    }
+
     void onValueStateChanged(ASYNC_VALUE_STATE /*state*/)
     {
         updateContent();
@@ -61,28 +141,170 @@ private:
     {
         if (!m_asyncValue)
         {
+            resetProgressTimers();
             setContentWidget(createNoAsyncValueWidgetImpl(this));
             return;
         }
 
         QWidget* newWidget = nullptr;
+        bool isInProgress = false;
+        // previous value or error stays visible while the value is refreshing
+        bool showStale = !m_isProgressWidgetShown && m_asyncValue->isRefreshing();
+        // progress widget is grabbed after access to keep the value lock short
+        qint64 holdTime = 0;
 
-        m_asyncValue->access([&newWidget, this](ValueType& value){
-            newWidget = createValueWidgetImpl(value, this);
-        }, [&newWidget, this](ErrorType& error){
-            newWidget = createErrorWidgetImpl(error, this);
-        }, [&newWidget, this](ProgressType& progress){
-            newWidget = createProgressWidgetImpl(progress, this);
+        m_asyncValue->access([&newWidget, &holdTime, this](ValueType& value){
+            if (!holdProgressWidget(holdTime))
+                newWidget = createValueWidgetImpl(value, this);
+        }, [&newWidget, &holdTime, this](ErrorType& error){
+            if (!holdProgressWidget(holdTime))
+                newWidget = createErrorWidgetImpl(error, this);
+        }, [&newWidget, &isInProgress, showStale, this](ProgressType& progress){
+            isInProgress = true;
+            if (showStale)
+                return;
+            // new progress started while snapshot of the previous one is shown
+            if (m_isProgressHoldActive)
+            {
+                m_isProgressHoldActive = false;
+                m_progressHoldTimer->stop();
+            }
+            if (!delayProgressWidget())
+                newWidget = createProgressWidgetImpl(progress, this);
         });
 
+        if (!isInProgress)
+            m_isProgressDelayElapsed = false;
+
+        if (holdTime > 0)
+            startProgressHold(holdTime);
+
+        if (isInProgress && showStale)
+        {
+            // keep current content widget
+            if (contentWidget())
+                return;
+
+            m_asyncValue->accessStale([&newWidget, this](ValueType& value){
+                newWidget = createValueWidgetImpl(value, this);
+            }, [&newWidget, this](ErrorType& error){
+                newWidget = createErrorWidgetImpl(error, this);
+            });
+
+            if (newWidget)
+            {
+                setContentWidget(newWidget);
+                return;
+            }
+        }
+
+        // keep current content widget
+        if (!newWidget && (m_isProgressDelayActive || m_isProgressHoldActive))
+            return;
+
         Q_ASSERT(newWidget);
         if (!newWidget)
             newWidget = createLabel("<no widget>", this);
 
         setContentWidget(newWidget);
+
+        m_isProgressWidgetShown = isInProgress;
+        if (m_isProgressWidgetShown)
+            m_progressWidgetShownTime.start();
+    }
+
+    // returns true if progress widget creation should be postponed
+    bool delayProgressWidget()
+    {
+        if (this->progressDelay() <= 0 || m_isProgressDelayElapsed || m_isProgressWidgetShown || !contentWidget())
+            return false;
+
+        if (!m_progressDelayTimer)
+        {
+            m_progressDelayTimer = new QTimer(this);
+            m_progressDelayTimer->setSingleShot(true);
+            QObject::connect(m_progressDelayTimer, &QTimer::timeout, this, [this]() {
+                m_isProgressDelayActive = false;
+                m_isProgressDelayElapsed = true;
+                updateContent();
+            });
+        }
+
+        if (!m_isProgressDelayActive)
+        {
+            m_isProgressDelayActive = true;
+            m_progressDelayTimer->start(this->progressDelay());
+        }
+
+        return true;
+    }
+
+    // returns true if progress widget should stay visible a bit longer
+    // called under the value lock, so it only sets holdTime for startProgressHold
+    bool holdProgressWidget(qint64& holdTime)
+    {
+        // short progress finished before progress widget was shown
+        if (m_isProgressDelayActive)
+        {
+            m_isProgressDelayActive = false;
+            m_progressDelayTimer->stop();
+            return false;
+        }
+
+        if (!m_isProgressWidgetShown || m_isProgressHoldActive)
+            return m_isProgressHoldActive;
+
+        holdTime = this->progressMinDuration() - m_progressWidgetShownTime.elapsed();
+        return holdTime > 0;
+    }
+
+    void startProgressHold(qint64 holdTime)
+    {
+        // progress object is destroyed already so replace progress widget with its snapshot
+        auto snapshot = new QLabel(this);
+        snapshot->setPixmap(contentWidget()->grab());
+        setContentWidget(snapshot);
+
+        if (!m_progressHoldTimer)
+        {
+            m_progressHoldTimer = new QTimer(this);
+            m_progressHoldTimer->setSingleShot(true);
+            QObject::connect(m_progressHoldTimer, &QTimer::timeout, this, [this]() {
+                m_isProgressHoldActive = false;
+                m_isProgressWidgetShown = false;
+                updateContent();
+            });
+        }
+
+        m_isProgressHoldActive = true;
+        m_progressHoldTimer->start(static_cast<int>(holdTime));
+    }
+
+    void resetProgressTimers()
+    {
+        if (m_progressDelayTimer)
+            m_progressDelayTimer->stop();
+        if (m_progressHoldTimer)
+            m_progressHoldTimer->stop();
+
+        m_isProgressDelayActive = false;
+        m_isProgressDelayElapsed = false;
+        m_isProgressHoldActive = false;
+        m_isProgressWidgetShown = false;
     }
 
     AsyncValueType* m_asyncValue = nullptr;
+    bool m_runOnVisiblePending = true;
+    bool m_stoppedWhileHidden = false;
+
+    QTimer* m_progressDelayTimer = nullptr;
+    bool m_isProgressDelayActive = false;
+    bool m_isProgressDelayElapsed = false;
+
+    QTimer* m_progressHoldTimer = nullptr;
+    bool m_isProgressHoldActive = false;
+    bool m_isProgressWidgetShown = false;
+    QElapsedTimer m_progressWidgetShownTime;
 };
 
 #endif // ASYNC_WIDGET_BASE_H
@@ -0,0 +1,172 @@
+/*
+   Copyright (c) 2018 Alex Zhondin <lexxmark.dev@gmail.com>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_WIDGET_PREPARED_H
+#define ASYNC_WIDGET_PREPARED_H
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include "AsyncWidget.h"
+
+// async widget that prepares data to show value (scales images, layouts text, etc.)
+// in a worker thread, so GUI thread only creates widget from ready data
+// worker gets a copy of the value (SourceType), so async value is not locked or referenced during preparation
+template <typename AsyncValueType, typename PreparedType_t, typename SourceType_t = typename AsyncValueType::ValueType>
+class AsyncWidgetPrepared : public AsyncWidget<AsyncValueType>
+{
+public:
+    using ValueType = typename AsyncValueType::ValueType;
+    using ErrorType = typename AsyncValueType::ErrorType;
+    using ProgressType = typename AsyncValueType::ProgressType;
+    using PreparedType = PreparedType_t;
+    using SourceType = SourceType_t;
+    using CopyFnType = std::function<SourceType(ValueType&)>;
+    using PrepareFnType = std::function<PreparedType(const SourceType&, QSize)>;
+
+    using AsyncWidget<AsyncValueType>::AsyncWidget;
+
+    // called in GUI thread while async value is locked for reading
+    // by default SourceType is constructed from the value,
+    // set it to convert types that cannot be used in worker threads (like QPixmap)
+    CopyFnType copyValue;
+
+    // called in a worker thread with the copy of the value and a copy of widget size
+    // it shouldn't access widget, value is prepared again when widget is resized
+    PrepareFnType prepareValue;
+
+    std::function<QWidget*(PreparedType&, QWidget*)> createPreparedWidget;
+
+protected:
+    virtual QWidget* createPreparedWidgetImpl(PreparedType& prepared, QWidget* parent)
+    {
+        if (createPreparedWidget)
+            return createPreparedWidget(prepared, parent);
+        else
+            return this->createLabel("<prepared widget is not implemented>", parent);
+    }
+
+    // widget to show while preparation is in progress
+    virtual QWidget* createPreparingWidgetImpl(QWidget* parent)
+    {
+        return new QWidget(parent);
+    }
+
+    QWidget* createValueWidgetImpl(ValueType& value, QWidget* parent) override
+    {
+        cancelPrepare();
+        m_source = nullptr;
+
+        if (!prepareValue)
+            return AsyncWidget<AsyncValueType>::createValueWidgetImpl(value, parent);
+
+        m_source = std::make_shared<SourceType>(copyValueImpl(value));
+        startPrepare();
+        return createPreparingWidgetImpl(parent);
+    }
+
+    QWidget* createErrorWidgetImpl(ErrorType& error, QWidget* parent) override
+    {
+        cancelPrepare();
+        m_source = nullptr;
+        return AsyncWidget<AsyncValueType>::createErrorWidgetImpl(error, parent);
+    }
+
+    QWidget* createProgressWidgetImpl(ProgressType& progress, QWidget* parent) override
+    {
+        cancelPrepare();
+        m_source = nullptr;
+        return AsyncWidget<AsyncValueType>::createProgressWidgetImpl(progress, parent);
+    }
+
+    void resizeEvent(QResizeEvent* event) override
+    {
+        AsyncWidget<AsyncValueType>::resizeEvent(event);
+
+        // running preparation restarts itself on completion if size differs
+        if (m_source && !m_prepareWatcher && m_preparedSize != this->size())
+            startPrepare();
+    }
+
+private:
+    using PreparedPtr = std::shared_ptr<PreparedType>;
+    using SourcePtr = std::shared_ptr<const SourceType>;
+
+    SourceType copyValueImpl(ValueType& value)
+    {
+        if (copyValue)
+            return copyValue(value);
+
+        return copyValueDefault(value, std::is_constructible<SourceType, ValueType&>());
+    }
+
+    static SourceType copyValueDefault(ValueType& value, std::true_type)
+    {
+        return SourceType(value);
+    }
+
+    static SourceType copyValueDefault(ValueType& /*value*/, std::false_type)
+    {
+        Q_ASSERT(false && "copyValue should be set to convert value to SourceType");
+        return SourceType();
+    }
+
+    void startPrepare()
+    {
+        Q_ASSERT(m_source);
+
+        m_preparedSize = this->size();
+
+        auto future = QtConcurrent::run([source = m_source, prepare = prepareValue, size = m_preparedSize]() {
+            return std::make_shared<PreparedType>(prepare(*source, size));
+        });
+
+        m_prepareWatcher = new QFutureWatcher<PreparedPtr>(this);
+        QObject::connect(m_prepareWatcher, &QFutureWatcherBase::finished, this, [this, watcher = m_prepareWatcher]() {
+            Q_ASSERT(watcher == m_prepareWatcher);
+
+            auto prepared = watcher->result();
+            cancelPrepare();
+
+            this->setContentWidget(createPreparedWidgetImpl(*prepared, this));
+
+            // widget was resized during preparation
+            if (m_preparedSize != this->size())
+                startPrepare();
+        });
+        m_prepareWatcher->setFuture(future);
+    }
+
+    void cancelPrepare()
+    {
+        if (!m_prepareWatcher)
+            return;
+
+        // results of the running preparation will be dropped
+        m_prepareWatcher->disconnect(this);
+        m_prepareWatcher->deleteLater();
+        m_prepareWatcher = nullptr;
+    }
+
+    QFutureWatcher<PreparedPtr>* m_prepareWatcher = nullptr;
+    // copy of the shown value, kept to prepare it again on resize
+    SourcePtr m_source;
+    QSize m_preparedSize;
+};
+
+#endif // ASYNC_WIDGET_PREPARED_H
@@ -17,6 +17,7 @@
 #include "AsyncWidgetProxy.h"
 #include <QLabel>
 #include <QResizeEvent>
+#include <QTimer>
 
 void AsyncWidgetProxy::setContentWidget(QWidget* content)
 {
@@ -31,6 +32,8 @@ void AsyncWidgetProxy::setContentWidget(QWidget* content)
 
     if (m_content)
     {
+        // content widget usually covers the proxy, so watch its paint events too
+        m_content->installEventFilter(this);
         m_content->setParent(this);
         m_content->setGeometry(rect());
         m_content->show();
@@ -48,6 +51,76 @@ void AsyncWidgetProxy::resizeEvent(QResizeEvent *event)
         m_content->setGeometry(QRect(QPoint(0, 0), event->size()));
 }
 
+void AsyncWidgetProxy::paintEvent(QPaintEvent *event)
+{
+    QWidget::paintEvent(event);
+    setExposed();
+}
+
+void AsyncWidgetProxy::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+
+    if (!m_isExposed)
+        return;
+
+    m_isExposed = false;
+
+    if (!m_runOnVisible)
+        return;
+
+    hiddenImpl();
+
+    if (!m_hiddenTimer)
+    {
+        m_hiddenTimer = new QTimer(this);
+        m_hiddenTimer->setSingleShot(true);
+        m_hiddenTimer->setInterval(ASYNC_WIDGET_HIDDEN_STOP_TIMEOUT);
+        connect(m_hiddenTimer, &QTimer::timeout, this, [this]() {
+            hiddenTimeoutImpl();
+        });
+    }
+    m_hiddenTimer->start();
+}
+
+bool AsyncWidgetProxy::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_content && event->type() == QEvent::Paint)
+        setExposed();
+
+    return QWidget::eventFilter(watched, event);
+}
+
+void AsyncWidgetProxy::setRunOnVisible(bool runOnVisible)
+{
+    if (m_runOnVisible == runOnVisible)
+        return;
+
+    m_runOnVisible = runOnVisible;
+
+    if (!m_runOnVisible && m_hiddenTimer)
+        m_hiddenTimer->stop();
+
+    if (m_runOnVisible && m_isExposed)
+        exposedImpl();
+}
+
+void AsyncWidgetProxy::setExposed()
+{
+    if (m_isExposed)
+        return;
+
+    m_isExposed = true;
+
+    if (!m_runOnVisible)
+        return;
+
+    if (m_hiddenTimer)
+        m_hiddenTimer->stop();
+
+    exposedImpl();
+}
+
 QWidget* AsyncWidgetProxy::createLabel(QString text, QWidget* parent)
 {
     auto label = new QLabel(text, parent);
@@ -18,6 +18,9 @@
 #define ASYNC_WIDGET_PROXY_H
 
 #include <QWidget>
+#include "../Config.h"
+
+class QTimer;
 
 class AsyncWidgetProxy : public QWidget
 {
@@ -32,11 +35,49 @@ public:
 
     static QWidget* createLabel(QString text, QWidget* parent);
 
+    // if enabled, async value is run when widget is painted first time
+    // and stopped when widget stays hidden longer than ASYNC_WIDGET_HIDDEN_STOP_TIMEOUT
+    bool isRunOnVisible() const { return m_runOnVisible; }
+    void setRunOnVisible(bool runOnVisible);
+
+    // progress widget is created only if progress lasts longer than the delay
+    // disabled by default (ASYNC_PROGRESS_WIDGET_SHOW_DELAY is 0), enable it only if
+    // value and error widgets don't keep references to the async value content,
+    // because the content is destroyed while widget is still shown during the delay
+    int progressDelay() const { return m_progressDelay; }
+    void setProgressDelay(int msec) { m_progressDelay = msec; }
+
+    // once shown, progress widget (or its snapshot) stays visible at least minimal duration
+    int progressMinDuration() const { return m_progressMinDuration; }
+    void setProgressMinDuration(int msec) { m_progressMinDuration = msec; }
+
+    // returns true if widget has been painted since it was shown last time
+    bool isExposed() const { return m_isExposed; }
+
 protected:
     void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+    // called when widget becomes visible on the screen
+    virtual void exposedImpl() {}
+    // called when widget becomes hidden
+    virtual void hiddenImpl() {}
+    // called when widget stays hidden longer than ASYNC_WIDGET_HIDDEN_STOP_TIMEOUT
+    virtual void hiddenTimeoutImpl() {}
 
 private:
+    void setExposed();
+
    QWidget* m_content = nullptr;
+
+   int m_progressDelay = ASYNC_PROGRESS_WIDGET_SHOW_DELAY;
+   int m_progressMinDuration = ASYNC_PROGRESS_WIDGET_MIN_DURATION;
+
+   bool m_runOnVisible = false;
+   bool m_isExposed = false;
+   QTimer* m_hiddenTimer = nullptr;
 };
 
 #endif // ASYNC_WIDGET_PROXY_H
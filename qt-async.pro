@@ -1,7 +1,11 @@
 TEMPLATE   = subdirs
 SUBDIRS   += qt-async-lib\
              tests\
+             benchmarks\
+             stress\
              demo
 
 tests.depends = qt-async-lib
+benchmarks.depends = qt-async-lib
+stress.depends = qt-async-lib
 demo.depends = qt-async-lib
@@ -0,0 +1,12 @@
+# sanitizer builds: qmake CONFIG+=tsan or qmake CONFIG+=asan
+# included by every sub-project, so library and executables are instrumented together
+# use Qt built with the same sanitizer to avoid false positives inside Qt
+tsan {
+    QMAKE_CXXFLAGS += -fsanitize=thread -fno-omit-frame-pointer -g
+    QMAKE_LFLAGS += -fsanitize=thread
+}
+
+asan {
+    QMAKE_CXXFLAGS += -fsanitize=address,undefined -fno-omit-frame-pointer -g
+    QMAKE_LFLAGS += -fsanitize=address,undefined
+}
@@ -0,0 +1,321 @@
+#include "StressHarness.h"
+#include "values/AsyncValueRunable.h"
+#include "values/AsyncValueRunThreadPool.h"
+#include "values/AsyncWatchdog.h"
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <array>
+#include <memory>
+#include <random>
+
+namespace
+{
+
+enum OPERATION
+{
+    OP_EMPLACE,
+    OP_ACCESS,
+    OP_WAIT,
+    OP_RUN,
+    OP_STOP_AND_WAIT,
+    OP_COUNT
+};
+
+const char* const operationNames[OP_COUNT] = {"emplaceValue", "access", "wait", "run", "stopAndWait"};
+const double operationWeights[OP_COUNT] = {20., 50., 10., 15., 5.};
+
+QAtomicInteger<qint64> lostStartRaces(0);
+QAtomicInteger<qint64> lostReruns(0);
+
+struct StressTrackErrorsPolicy : public AsyncTrackErrorsPolicyDefault
+{
+    // regression check: concurrent run() calls should never start progress twice
+    void startProgressWhileInProgress() const
+    {
+        lostStartRaces.fetchAndAddRelaxed(1);
+    }
+};
+
+class StressProgress : public AsyncProgressRerun
+{
+public:
+    using AsyncProgressRerun::AsyncProgressRerun;
+
+    ~StressProgress()
+    {
+        // regression check: rerun requested after the last resetIfRerunRequested check
+        if (m_isRerunRequested)
+        {
+            lostReruns.fetchAndAddRelaxed(1);
+            m_isRerunRequested = false;
+        }
+    }
+};
+
+using StressValue = AsyncValueRunableFn<int, AsyncError, StressProgress, StressTrackErrorsPolicy>;
+
+// log-linear latency histogram with 1/16 precision
+class LatencyHistogram
+{
+public:
+    void record(qint64 ns)
+    {
+        ++m_count;
+        ++m_buckets[bucket(quint64(qMax(ns, qint64(0))))];
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        m_count += other.m_count;
+        for (size_t i = 0; i < m_buckets.size(); ++i)
+            m_buckets[i] += other.m_buckets[i];
+    }
+
+    qint64 count() const { return m_count; }
+
+    qint64 percentile(double p) const
+    {
+        const auto target = static_cast<qint64>(p * m_count);
+        qint64 sum = 0;
+        for (size_t i = 0; i < m_buckets.size(); ++i)
+        {
+            sum += m_buckets[i];
+            if (sum > target)
+                return lowerBound(i);
+        }
+        return lowerBound(m_buckets.size() - 1);
+    }
+
+private:
+    enum { SUB_BUCKETS = 16, SUB_BITS = 4, EXPONENTS = 64 - SUB_BITS };
+
+    static size_t bucket(quint64 ns)
+    {
+        if (ns < SUB_BUCKETS)
+            return size_t(ns);
+
+        int exponent = 63;
+        while (!(ns & (quint64(1) << exponent)))
+            --exponent;
+
+        auto shift = exponent - SUB_BITS;
+        auto subBucket = (ns >> shift) & (SUB_BUCKETS - 1);
+        return size_t(shift + 1) * SUB_BUCKETS + size_t(subBucket);
+    }
+
+    static qint64 lowerBound(size_t index)
+    {
+        if (index < SUB_BUCKETS)
+            return qint64(index);
+
+        auto shift = index / SUB_BUCKETS - 1;
+        auto subBucket = index % SUB_BUCKETS;
+        return qint64((SUB_BUCKETS + subBucket) << shift);
+    }
+
+    qint64 m_count = 0;
+    std::array<qint64, (EXPONENTS + 1) * SUB_BUCKETS> m_buckets = {};
+};
+
+void calculate(StressProgress& progress, StressValue& value)
+{
+    const int steps = 16;
+    int result = 0;
+
+    for (int step = 0; step < steps; ++step)
+    {
+        if (progress.isStopRequested())
+        {
+            value.emplaceError("Stopped");
+            return;
+        }
+
+        for (int i = 0; i < 1000; ++i)
+            result += i % (step + 1);
+
+        progress.setProgress(step, steps);
+    }
+
+    value.emplaceValue(result);
+}
+
+QString formatNs(qint64 ns)
+{
+    if (ns < 10000)
+        return QString("%1ns").arg(ns);
+    if (ns < 10000000)
+        return QString("%1us").arg(ns / 1000);
+    return QString("%1ms").arg(ns / 1000000);
+}
+
+} // end anonymous namespace
+
+StressHarness::StressHarness(const StressOptions& options)
+    : m_options(options)
+{
+}
+
+bool StressHarness::run()
+{
+    QTextStream out(stdout);
+
+    out << "values: " << m_options.values
+        << ", threads: " << m_options.threads
+        << ", seconds: " << m_options.seconds
+        << ", seed: " << m_options.seed << '\n';
+    out.flush();
+
+    // report stalls while hammering values
+    AsyncWatchdogThresholds thresholds;
+    thresholds.progressMs = 10000;
+    thresholds.waitMs = 10000;
+    thresholds.lockHoldMs = 1000;
+    AsyncWatchdog::start(thresholds);
+
+    QThreadPool pool;
+    pool.setObjectName("stress");
+
+    std::vector<std::unique_ptr<StressValue>> values;
+    values.reserve(size_t(m_options.values));
+    for (int i = 0; i < m_options.values; ++i)
+    {
+        values.push_back(std::make_unique<StressValue>(AsyncInitByValue(), 0));
+
+        auto& value = *values.back();
+        value.deferFn = [&value, &pool](const StressValue::RunFnType& fn) {
+            asyncValueRunThreadPool(&pool, value, fn, "Calculating...", ASYNC_CAN_REQUEST_STOP::YES);
+        };
+        value.runFn = calculate;
+    }
+
+    QAtomicInt stop(0);
+    std::vector<LatencyHistogram> histograms(size_t(m_options.threads * OP_COUNT));
+    std::vector<std::unique_ptr<QThread>> workers;
+
+    for (int index = 0; index < m_options.threads; ++index)
+    {
+        auto histogram = &histograms[size_t(index * OP_COUNT)];
+
+        workers.emplace_back(QThread::create([this, index, histogram, &values, &stop]() {
+            // every worker has its own reproducible sequence of operations
+            std::mt19937 random(m_options.seed + quint32(index));
+            std::uniform_int_distribution<int> valueDistribution(0, m_options.values - 1);
+            std::discrete_distribution<int> operationDistribution(std::begin(operationWeights), std::end(operationWeights));
+
+            QElapsedTimer timer;
+
+            while (!stop.loadAcquire())
+            {
+                auto& value = *values[size_t(valueDistribution(random))];
+                auto operation = operationDistribution(random);
+
+                timer.start();
+
+                switch (operation)
+                {
+                case OP_EMPLACE:
+                    value.emplaceValue(int(random() % 1000));
+                    break;
+
+                case OP_ACCESS:
+                    value.access([](int number) {
+                        Q_ASSERT(number >= 0);
+                    }, [](const AsyncError& error) {
+                        Q_ASSERT(!error.text().isEmpty());
+                    }, [](StressProgress& progress) {
+                        Q_ASSERT(progress.progress() <= 1.f);
+                    });
+                    break;
+
+                case OP_WAIT:
+                    value.wait();
+                    break;
+
+                case OP_RUN:
+                    value.run();
+                    break;
+
+                case OP_STOP_AND_WAIT:
+                    value.stopAndWait();
+                    break;
+                }
+
+                histogram[operation].record(timer.nsecsElapsed());
+            }
+        }));
+    }
+
+    QElapsedTimer duration;
+    duration.start();
+
+    for (auto& worker : workers)
+        worker->start();
+
+    QThread::sleep(static_cast<unsigned long>(m_options.seconds));
+    stop.storeRelease(1);
+
+    for (auto& worker : workers)
+    {
+        if (!worker->wait(60000))
+            qFatal("Worker thread doesn't finish, possible deadlock (seed %u)", m_options.seed);
+    }
+
+    const auto elapsedNs = duration.nsecsElapsed();
+
+    // let all runs complete
+    for (auto& value : values)
+        value->wait();
+    pool.waitForDone();
+
+    AsyncWatchdog::stop();
+
+    // check every value has settled
+    int unsettled = 0;
+    for (auto& value : values)
+    {
+        if (value->accessProgress([](StressProgress&) {}))
+            ++unsettled;
+    }
+
+    LatencyHistogram total;
+
+    out << '\n' << qSetFieldWidth(14) << left << "operation"
+        << "count" << "ops/s" << "p50" << "p99" << "p999" << qSetFieldWidth(0) << '\n';
+
+    for (int operation = 0; operation < OP_COUNT; ++operation)
+    {
+        LatencyHistogram histogram;
+        for (int index = 0; index < m_options.threads; ++index)
+            histogram.merge(histograms[size_t(index * OP_COUNT + operation)]);
+        total.merge(histogram);
+
+        out << qSetFieldWidth(14) << operationNames[operation]
+            << histogram.count()
+            << qint64(histogram.count() * 1e9 / elapsedNs)
+            << formatNs(histogram.percentile(0.5))
+            << formatNs(histogram.percentile(0.99))
+            << formatNs(histogram.percentile(0.999))
+            << qSetFieldWidth(0) << '\n';
+    }
+
+    out << qSetFieldWidth(14) << "total"
+        << total.count()
+        << qint64(total.count() * 1e9 / elapsedNs)
+        << formatNs(total.percentile(0.5))
+        << formatNs(total.percentile(0.99))
+        << formatNs(total.percentile(0.999))
+        << qSetFieldWidth(0) << "\n\n";
+
+    const auto startRaces = lostStartRaces.loadAcquire();
+    const auto reruns = lostReruns.loadAcquire();
+
+    out << "lost start races: " << startRaces << '\n';
+    out << "lost reruns: " << reruns << '\n';
+    out << "unsettled values: " << unsettled << '\n';
+    out.flush();
+
+    return startRaces == 0 && reruns == 0 && unsettled == 0;
+}
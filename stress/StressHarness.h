@@ -0,0 +1,29 @@
+#ifndef STRESS_HARNESS_H
+#define STRESS_HARNESS_H
+
+#include <QString>
+#include <QVector>
+
+struct StressOptions
+{
+    int values = 10000;
+    int threads = 32;
+    int seconds = 10;
+    quint32 seed = 0;
+};
+
+// hammers many async values from many threads with a reproducible random mix of
+// emplaceValue, access, wait, run (rerun) and stopAndWait operations
+class StressHarness
+{
+public:
+    explicit StressHarness(const StressOptions& options);
+
+    // returns false if consistency checks failed
+    bool run();
+
+private:
+    StressOptions m_options;
+};
+
+#endif // STRESS_HARNESS_H
@@ -0,0 +1,37 @@
+#include "StressHarness.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QThread>
+#include <random>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("qt-async-stress");
+
+    StressOptions options;
+    options.threads = QThread::idealThreadCount() * 4;
+    options.seed = std::random_device()();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Stress test of async values");
+    parser.addHelpOption();
+    QCommandLineOption valuesOption("values", "Number of async values.", "count", QString::number(options.values));
+    QCommandLineOption threadsOption("threads", "Number of worker threads.", "count", QString::number(options.threads));
+    QCommandLineOption secondsOption("seconds", "Test duration.", "seconds", QString::number(options.seconds));
+    QCommandLineOption seedOption("seed", "Random seed to reproduce operations sequence.", "seed");
+    parser.addOption(valuesOption);
+    parser.addOption(threadsOption);
+    parser.addOption(secondsOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+
+    options.values = qMax(1, parser.value(valuesOption).toInt());
+    options.threads = qMax(1, parser.value(threadsOption).toInt());
+    options.seconds = qMax(1, parser.value(secondsOption).toInt());
+    if (parser.isSet(seedOption))
+        options.seed = parser.value(seedOption).toUInt();
+
+    StressHarness harness(options);
+    return harness.run() ? 0 : 1;
+}
@@ -0,0 +1,31 @@
+QT += core concurrent
+QT -= gui
+
+TARGET = qt-async-stress
+
+CONFIG   += console
+CONFIG   -= app_bundle
+CONFIG   += c++14
+
+TEMPLATE = app
+
+include(../sanitizers.pri)
+
+HEADERS += \
+    StressHarness.h
+
+SOURCES += main.cpp \
+    StressHarness.cpp
+
+INCLUDEPATH += ../qt-async-lib
+
+win32 {
+    CONFIG(debug, debug|release): ASYNC_LIB_PATH = $$OUT_PWD/../qt-async-lib/debug
+    CONFIG(release, debug|release): ASYNC_LIB_PATH = $$OUT_PWD/../qt-async-lib/release
+} else:unix {
+    ASYNC_LIB_PATH = $$OUT_PWD/../qt-async-lib
+}
+
+LIBS += -L$$ASYNC_LIB_PATH -lqt-async-lib
+
+win32:PRE_TARGETDEPS += $$ASYNC_LIB_PATH/qt-async-lib.lib
@@ -1,10 +1,24 @@
 #include "TestAsyncValue.h"
 #include <QtTest/QtTest>
+#include <QtConcurrent>
 #include "values/AsyncValue.h"
 #include "values/AsyncValueRunThread.h"
 #include "values/AsyncValueRunThreadPool.h"
+#include "values/AsyncValueRunInline.h"
 #include "values/AsyncValueRunNetwork.h"
+#include "values/AsyncValueRunFuture.h"
 #include "values/AsyncValueRunable.h"
+#include "values/AsyncTrace.h"
+#include "values/AsyncLockStats.h"
+#include "values/AsyncMetrics.h"
+#include "values/AsyncWatchdog.h"
+#include "values/AsyncMemoryResource.h"
+#include "values/AsyncValueCompact.h"
+#include "values/AsyncValueCompactNotifier.h"
+#include "values/AsyncValueEvictable.h"
+#include "values/AsyncValuePersistent.h"
+#include "values/AsyncValueLazy.h"
+#include "values/AsyncReclaimer.h"
 
 void TestAsyncValue::simple()
 {
@@ -45,6 +59,125 @@ void TestAsyncValue::simple()
     }
 }
 
+void TestAsyncValue::version()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 1);
+    auto version = value.version();
+    QVERIFY(version > 0);
+
+    quint64 accessedVersion = 0;
+    int accessCount = 0;
+    auto poll = [&value, &accessedVersion, &accessCount]() {
+        return value.accessIfChangedSince(accessedVersion, [&accessCount](int) {
+            accessCount += 1;
+        }, [](const AsyncError&) {
+            QFAIL("Unexpected error");
+        }, [](const AsyncProgress&) {
+            QFAIL("Unexpected progress");
+        });
+    };
+
+    QVERIFY(poll());
+    QCOMPARE(accessedVersion, version);
+    QVERIFY(!poll());
+    QCOMPARE(accessCount, 1);
+
+    value.emplaceValue(2);
+    QVERIFY(value.version() > version);
+    QVERIFY(poll());
+    QVERIFY(!poll());
+    QCOMPARE(accessCount, 2);
+
+    // every progress change is counted
+    version = value.version();
+    asyncValueRunThreadPool(value, [](AsyncProgress&, AsyncValue<int>& value) {
+        value.emplaceValue(3);
+    }, "", ASYNC_CAN_REQUEST_STOP::NO);
+    value.wait();
+    QCOMPARE(value.version(), version + 3);
+}
+
+void TestAsyncValue::staleWhileRefresh()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 1);
+    value.setStaleWhileRefresh(true);
+    QVERIFY(!value.isRefreshing());
+
+    QSemaphore started;
+    QSemaphore finish;
+    auto refresh = [&started, &finish](bool emplace) {
+        return [&started, &finish, emplace](AsyncProgress&, AsyncValue<int>& value) {
+            started.release();
+            finish.acquire();
+            if (emplace)
+                value.emplaceValue(2);
+        };
+    };
+
+    asyncValueRunThreadPool(value, refresh(true), "", ASYNC_CAN_REQUEST_STOP::NO);
+    started.acquire();
+
+    // previous value is accessible while refreshing
+    QVERIFY(value.isRefreshing());
+    QVERIFY(!value.accessValue([](int) {}));
+    QVERIFY(value.accessStale([](int value) {
+        QCOMPARE(value, 1);
+    }, [](const AsyncError&) {
+        QFAIL("Unexpected error");
+    }));
+
+    finish.release();
+    value.wait();
+    QVERIFY(!value.isRefreshing());
+    QVERIFY(value.accessValue([](int value) {
+        QCOMPARE(value, 2);
+    }));
+
+    // refresh without result keeps previous value
+    asyncValueRunThreadPool(value, refresh(false), "", ASYNC_CAN_REQUEST_STOP::NO);
+    started.acquire();
+    finish.release();
+    value.wait();
+    QVERIFY(value.accessValue([](int value) {
+        QCOMPARE(value, 2);
+    }));
+}
+
+void TestAsyncValue::notifyPolicy()
+{
+    using AsyncIntCallbacks = AsyncValueTemplate<int, AsyncError, AsyncProgress, AsyncTrackErrorsPolicyDefault, AsyncTracePolicyDefault, AsyncNotifyPolicyCallbacks>;
+    AsyncIntCallbacks value(AsyncInitByValue(), 0);
+
+    QVector<ASYNC_VALUE_STATE> states;
+    AsyncStateCallback callback([](void* context, ASYNC_VALUE_STATE state) {
+        static_cast<QVector<ASYNC_VALUE_STATE>*>(context)->append(state);
+    }, &states);
+    value.subscribe(&callback);
+
+    asyncValueRunThreadPool(value, [](AsyncProgress&, AsyncIntCallbacks& value) {
+        value.emplaceValue(1);
+    }, "", ASYNC_CAN_REQUEST_STOP::NO);
+    value.wait();
+    value.emplaceError("error");
+
+    value.unsubscribe(&callback);
+    value.emplaceValue(2);
+
+    QCOMPARE(states, QVector<ASYNC_VALUE_STATE>({ASYNC_VALUE_STATE::PROGRESS, ASYNC_VALUE_STATE::VALUE, ASYNC_VALUE_STATE::ERROR}));
+
+    // value without notifications still can be waited for
+    using AsyncIntSilent = AsyncValueTemplate<int, AsyncError, AsyncProgress, AsyncTrackErrorsPolicyDefault, AsyncTracePolicyDefault, AsyncNotifyPolicyNone>;
+    AsyncIntSilent silent(AsyncInitByValue(), 0);
+    asyncValueRunThreadPool(silent, [](AsyncProgress&, AsyncIntSilent& value) {
+        value.emplaceValue(1);
+    }, "", ASYNC_CAN_REQUEST_STOP::NO);
+    silent.wait([](int value) {
+        QCOMPARE(value, 1);
+    }, [](const AsyncError&) {
+        QFAIL("Unexpected error");
+    });
+}
+
 void TestAsyncValue::runInThread()
 {
     AsyncValue<int> value(AsyncInitByValue(), 8);
@@ -71,6 +204,76 @@ void TestAsyncValue::runInThreadPool()
     value.wait([](int val){
         QCOMPARE(val, 42);
     }, AsyncNoOp());
+
+    // calculation dropped by the pool runs stopped, so the value doesn't stay in progress
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    QSemaphore release;
+    QtConcurrent::run(&pool, [&release]() {
+        release.acquire();
+    });
+
+    asyncValueRunThreadPool(&pool, value, [](AsyncProgress& progress, AsyncValue<int>& value) {
+        if (progress.isStopRequested())
+            value.emplaceError("Stopped");
+        else
+            value.emplaceValue(43);
+    }, "", ASYNC_CAN_REQUEST_STOP::YES);
+
+    pool.clear();
+    QVERIFY(value.accessError([](const AsyncError& error) {
+        QCOMPARE(error.text(), QString("Stopped"));
+    }));
+
+    release.release();
+    pool.waitForDone();
+}
+
+void TestAsyncValue::runInline()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+    QSignalSpy spy(&value, &AsyncValueBase::stateChanged);
+
+    // value is published without progress state
+    QVERIFY(asyncValueRunInline(value, [](AsyncProgress&, AsyncValue<int>& value) {
+        value.emplaceValue(1);
+    }, "", ASYNC_CAN_REQUEST_STOP::NO));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.takeFirst().at(0).value<ASYNC_VALUE_STATE>(), ASYNC_VALUE_STATE::VALUE);
+
+    // unknown calculation goes to thread pool, cheap one runs inline next time
+    auto cheap = [](AsyncProgress&, AsyncValue<int>& value) {
+        value.emplaceValue(2);
+    };
+
+    QVERIFY(asyncValueRunAdaptive(value, cheap, "", ASYNC_CAN_REQUEST_STOP::NO));
+    value.wait();
+    QCOMPARE(spy.count(), 2);
+    spy.clear();
+
+    QVERIFY(asyncValueRunAdaptive(value, cheap, "", ASYNC_CAN_REQUEST_STOP::NO));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.takeFirst().at(0).value<ASYNC_VALUE_STATE>(), ASYNC_VALUE_STATE::VALUE);
+    QVERIFY(value.accessValue([](int value) {
+        QCOMPARE(value, 2);
+    }));
+
+    // mutable functors are accepted
+    int runs = 0;
+    QVERIFY(asyncValueRunAdaptive(value, [runs](AsyncProgress&, AsyncValue<int>& value) mutable {
+        value.emplaceValue(++runs);
+    }, "", ASYNC_CAN_REQUEST_STOP::NO));
+    value.wait();
+    QVERIFY(value.accessValue([](int value) {
+        QCOMPARE(value, 1);
+    }));
+
+    // routines behind std::function are estimated by their own estimate objects
+    AsyncRunEstimate estimate;
+    std::function<void(AsyncProgress&, AsyncValue<int>&)> routine = cheap;
+    QVERIFY(asyncValueRunAdaptive(estimate, value, routine, "", ASYNC_CAN_REQUEST_STOP::NO));
+    value.wait();
+    QVERIFY(estimate.averageNs() >= 0);
 }
 
 void TestAsyncValue::catchDeadlock()
@@ -142,6 +345,59 @@ void TestAsyncValue::wait()
     }
 }
 
+void TestAsyncValue::manyWaiters()
+{
+    AsyncValue<int> value(AsyncInitByValue(), 8);
+
+    // number of waiters is not limited, only waiters of the value are woken up
+    auto progress = std::make_unique<AsyncProgress>("", ASYNC_CAN_REQUEST_STOP::NO);
+    auto progressPtr = progress.get();
+    QVERIFY(value.startProgress(std::move(progress)));
+
+    QThreadPool manyPool;
+    manyPool.setMaxThreadCount(1000);
+    manyPool.setStackSize(256 * 1024);
+
+    QAtomicInt woken;
+    for (int i = 0; i < 1000; ++i)
+    {
+        QtConcurrent::run(&manyPool, [&value, &woken]() {
+            value.wait([&woken](int val) {
+                if (val == 43)
+                    woken.ref();
+            }, AsyncNoOp());
+        });
+    }
+
+    value.emplaceValue(43);
+    value.completeProgress(progressPtr);
+    manyPool.waitForDone();
+    QCOMPARE(woken.load(), 1000);
+}
+
+void TestAsyncValue::waitAndDestroy()
+{
+    QThreadPool pool;
+
+    // waiter owns the value and destroys it as soon as wait returns
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto value = std::make_unique<AsyncValue<int>>(AsyncInitByValue(), 0);
+        QObject::connect(value.get(), &AsyncValueBase::stateChanged, value.get(), [](ASYNC_VALUE_STATE) {}, Qt::DirectConnection);
+
+        asyncValueRunThreadPool(&pool, *value, [i](AsyncProgress&, AsyncValue<int>& value) {
+            value.emplaceValue(i);
+        }, "", ASYNC_CAN_REQUEST_STOP::NO);
+
+        value->wait([i](int val) {
+            QCOMPARE(val, i);
+        }, AsyncNoOp());
+        value.reset();
+    }
+
+    pool.waitForDone();
+}
+
 void TestAsyncValue::run()
 {
     AsyncValueRunableFn<int> value(AsyncInitByValue(), 8);
@@ -169,6 +425,46 @@ void TestAsyncValue::run()
     QVERIFY(rerunTotal >= 2);
 }
 
+void TestAsyncValue::concurrentRun()
+{
+    AsyncValueRunableFn<int> value(AsyncInitByValue(), 0);
+
+    QThreadPool pool;
+    QAtomicInt failedStarts;
+    QAtomicInt requested;
+
+    value.deferFn = [&value, &pool, &failedStarts](const AsyncValueRunableFn<int>::RunFnType& fn) {
+        if (!asyncValueRunThreadPool(&pool, value, fn, "", ASYNC_CAN_REQUEST_STOP::YES))
+            failedStarts.ref();
+    };
+    value.runFn = [&requested](AsyncProgressRerun&, AsyncValueRunableFn<int>& value) {
+        value.emplaceValue(requested.loadAcquire());
+    };
+
+    QThreadPool callers;
+    callers.setMaxThreadCount(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        QtConcurrent::run(&callers, [&value, &requested]() {
+            for (int j = 0; j < 1000; ++j)
+            {
+                requested.ref();
+                value.run();
+            }
+        });
+    }
+    callers.waitForDone();
+
+    value.wait();
+    pool.waitForDone();
+
+    // no run() call is lost, the last calculation sees all requests
+    QCOMPARE(failedStarts.load(), 0);
+    QVERIFY(value.accessValue([](int val) {
+        QCOMPARE(val, 4000);
+    }));
+}
+
 void TestAsyncValue::network()
 {
     AsyncValue<int> value(AsyncInitByValue(), 8);
@@ -194,3 +490,573 @@ void TestAsyncValue::network()
 
     QVERIFY(success);
 }
+
+void TestAsyncValue::future()
+{
+    // QFuture result and exception feed value and error
+    AsyncValue<int> value(AsyncInitByValue(), 0);
+    QVERIFY(asyncValueRunFuture(QtConcurrent::run([]() {
+        return 42;
+    }), value, AsyncFutureResult(), "", ASYNC_CAN_REQUEST_STOP::NO));
+    QTRY_VERIFY(value.accessValue([](int value) {
+        QCOMPARE(value, 42);
+    }));
+
+    QVERIFY(asyncValueRunFuture(QtConcurrent::run([]() -> int {
+        throw std::runtime_error("failed");
+    }), value, AsyncFutureResult(), "", ASYNC_CAN_REQUEST_STOP::NO));
+    QTRY_VERIFY(value.accessError(AsyncNoOp()));
+
+    // stop request completes the run without waiting for QtConcurrent::run task
+    QSemaphore release;
+    auto longFuture = QtConcurrent::run([&release]() {
+        release.acquire();
+        return 43;
+    });
+    QVERIFY(asyncValueRunFuture(longFuture, value, AsyncFutureResult(), "", ASYNC_CAN_REQUEST_STOP::YES));
+    value.accessProgress([](AsyncProgress& progress) {
+        progress.requestStop();
+    });
+    QTRY_VERIFY(value.accessError([](const AsyncError& error) {
+        QCOMPARE(error.text(), QString("Canceled"));
+    }));
+    release.release();
+    longFuture.waitForFinished();
+
+    // std::future is polled without blocking
+    std::promise<int> promise;
+    QVERIFY(asyncValueRunStdFuture(promise.get_future(), 10, value, AsyncFutureResult(), "", ASYNC_CAN_REQUEST_STOP::NO));
+    promise.set_value(7);
+    QTRY_VERIFY(value.accessValue([](int value) {
+        QCOMPARE(value, 7);
+    }));
+
+    // value is exposed as QFuture
+    auto progress = std::make_unique<AsyncProgress>("", ASYNC_CAN_REQUEST_STOP::YES);
+    auto progressPtr = progress.get();
+    QVERIFY(value.startProgress(std::move(progress)));
+
+    auto future = asyncValueToFuture(value);
+    QVERIFY(!future.isFinished());
+    value.emplaceValue(8);
+    value.completeProgress(progressPtr);
+    QTRY_VERIFY(future.isFinished());
+    QCOMPARE(future.result(), 8);
+
+    // future cancellation requests value to stop
+    progress = std::make_unique<AsyncProgress>("", ASYNC_CAN_REQUEST_STOP::YES);
+    progressPtr = progress.get();
+    QVERIFY(value.startProgress(std::move(progress)));
+
+    future = asyncValueToFuture(value);
+    future.cancel();
+    QTRY_VERIFY(progressPtr->isStopRequested());
+    value.emplaceError("stopped");
+    value.completeProgress(progressPtr);
+    QTRY_VERIFY(future.isFinished());
+}
+
+void TestAsyncValue::trace()
+{
+    using AsyncTracedInt = AsyncValueTemplate<int, AsyncError, AsyncProgress, AsyncTrackErrorsPolicyDefault, AsyncTracePolicyChrome>;
+    AsyncTracedInt value(AsyncInitByValue(), 8);
+
+    AsyncTrace::clear();
+
+    asyncValueRunThreadPool(value, [](AsyncProgress& progress, AsyncTracedInt& value) {
+        progress.setProgress(1, 2);
+        value.emplaceValue(42);
+    }, "", ASYNC_CAN_REQUEST_STOP::NO);
+
+    value.wait();
+
+    auto json = QJsonDocument::fromJson(AsyncTrace::toChromeTraceJson());
+    auto events = json.object()["traceEvents"].toArray();
+
+    QStringList names;
+    for (auto event : events)
+        names.append(event.toObject()["name"].toString());
+
+    QVERIFY(names.contains("queued"));
+    QVERIFY(names.contains("running"));
+    QVERIFY(names.contains("progress"));
+    QVERIFY(names.contains("value"));
+    QVERIFY(names.contains("completed"));
+}
+
+void TestAsyncValue::lockStats()
+{
+    AsyncLockStats::reset();
+
+    AsyncValue<int> value(AsyncInitByValue(), 8);
+    value.emplaceValue(42);
+    QVERIFY(value.accessValue([](int value) {
+        QCOMPARE(value, 42);
+    }));
+
+    auto stats = AsyncLockStats::snapshot();
+    if (!AsyncLockStats::isEnabled())
+    {
+        QVERIFY(stats.isEmpty());
+        return;
+    }
+
+    quint64 acquisitions = 0;
+    for (const auto& stat : stats)
+    {
+        QVERIFY(stat.maxWaitNs <= stat.totalWaitNs);
+        QVERIFY(stat.maxHoldNs <= stat.totalHoldNs);
+        acquisitions += stat.acquisitions;
+    }
+
+    // write and content locks of emplaceValue plus content lock of accessValue
+    QVERIFY(acquisitions >= 3);
+    QVERIFY(!AsyncLockStats::dump().isEmpty());
+}
+
+void TestAsyncValue::metrics()
+{
+    auto json = QJsonDocument::fromJson(AsyncMetrics::toJson()).object();
+    QCOMPARE(json["enabled"].toBool(), AsyncMetrics::isEnabled());
+    QVERIFY(json.contains("values"));
+    QVERIFY(json.contains("runs"));
+
+    if (!AsyncMetrics::isEnabled())
+        return;
+
+    auto before = AsyncMetrics::snapshot();
+    const auto& poolRunsBefore = before.runs[static_cast<int>(ASYNC_RUN_HELPER::THREAD_POOL)];
+
+    {
+        AsyncValue<int> value(AsyncInitByValue(), 8);
+
+        asyncValueRunThreadPool(value, [](AsyncProgress&, AsyncValue<int>& value) {
+            value.emplaceValue(42);
+        }, "", ASYNC_CAN_REQUEST_STOP::NO);
+
+        value.wait();
+
+        auto after = AsyncMetrics::snapshot();
+        const auto& poolRunsAfter = after.runs[static_cast<int>(ASYNC_RUN_HELPER::THREAD_POOL)];
+
+        QCOMPARE(after.values, before.values + 1);
+        QCOMPARE(poolRunsAfter.started, poolRunsBefore.started + 1);
+        QCOMPARE(poolRunsAfter.completed, poolRunsBefore.completed + 1);
+        QCOMPARE(poolRunsAfter.stopped, poolRunsBefore.stopped);
+    }
+
+    QCOMPARE(AsyncMetrics::snapshot().values, before.values);
+}
+
+void TestAsyncValue::watchdog()
+{
+    QMutex stallsLock;
+    QVector<AsyncStall> stalls;
+
+    AsyncWatchdog::setReporter([&stallsLock, &stalls](const AsyncStall& stall) {
+        QMutexLocker locker(&stallsLock);
+        stalls.append(stall);
+    });
+
+    AsyncWatchdogThresholds thresholds;
+    thresholds.lockHoldMs = 50;
+    thresholds.checkIntervalMs = 10;
+    AsyncWatchdog::start(thresholds);
+    QVERIFY(AsyncWatchdog::isRunning());
+
+    AsyncValue<int> value(AsyncInitByValue(), 8);
+    value.accessValue([](int) {
+        QThread::msleep(300);
+    });
+
+    AsyncWatchdog::stop();
+    AsyncWatchdog::setReporter(nullptr);
+    QVERIFY(!AsyncWatchdog::isRunning());
+
+    QCOMPARE(stalls.size(), 1);
+    QVERIFY(stalls[0].kind == ASYNC_STALL::LOCK_HOLD);
+    QCOMPARE(stalls[0].value, static_cast<const void*>(&value));
+    QCOMPARE(stalls[0].site, QString("access"));
+    QVERIFY(stalls[0].stuckMs >= thresholds.lockHoldMs);
+}
+
+void TestAsyncValue::memoryResource()
+{
+    AsyncMonotonicResource arena(256);
+
+    std::vector<std::unique_ptr<AsyncValue<QString>>> values;
+    {
+        AsyncMemoryResourceScope scope(&arena);
+        for (int i = 0; i < 100; ++i)
+            values.push_back(std::make_unique<AsyncValue<QString>>(AsyncInitByValue(), QString::number(i)));
+    }
+    QVERIFY(AsyncMemoryResource::threadDefault() == nullptr);
+
+    for (auto& value : values)
+    {
+        QVERIFY(value->memoryResource() == &arena);
+
+        asyncValueRunThreadPool(*value, [](AsyncProgress&, AsyncValue<QString>& value) {
+            value.emplaceValue("calculated");
+        }, "", ASYNC_CAN_REQUEST_STOP::NO);
+    }
+
+    for (auto& value : values)
+    {
+        value->wait();
+        QVERIFY(value->accessValue([](const QString& value) {
+            QCOMPARE(value, QString("calculated"));
+        }));
+    }
+
+    // std::unique_ptr is accepted as well
+    values.front()->moveValue(std::make_unique<QString>("moved"));
+
+    values.clear();
+    arena.release();
+
+    {
+        AsyncMemoryResourceScope scope(AsyncMemoryResource::threadPools());
+        AsyncValue<int> value(AsyncInitByValue(), 1);
+        value.emplaceError("error");
+        value.emplaceValue(2);
+        QVERIFY(value.accessValue([](int value) {
+            QCOMPARE(value, 2);
+        }));
+    }
+}
+
+void TestAsyncValue::compactValue()
+{
+    AsyncValueCompact<QString> value(AsyncInitByError(), "no value");
+    QVERIFY(value.accessError([](const AsyncError& error) {
+        QCOMPARE(error.text(), QString("no value"));
+    }));
+
+    QVector<ASYNC_VALUE_STATE> states;
+    auto subscription = value.subscribe([&states](ASYNC_VALUE_STATE state) {
+        states.append(state);
+    });
+
+    AsyncValueCompactNotifier notifier(value);
+    QSignalSpy spy(&notifier, &AsyncValueCompactNotifier::stateChanged);
+
+    asyncValueRunThreadPool(value, [](AsyncProgress& progress, AsyncValueCompact<QString>& value) {
+        progress.setProgress(0.5f);
+        value.emplaceValue("calculated");
+    }, "", ASYNC_CAN_REQUEST_STOP::NO);
+
+    value.wait([](const QString& value) {
+        QCOMPARE(value, QString("calculated"));
+    }, [](const AsyncError&) {
+        QFAIL("Unexpected error");
+    });
+
+    // waits for the last notification from the worker thread
+    value.unsubscribe(subscription);
+
+    QCOMPARE(states.size(), 2);
+    QVERIFY(states[0] == ASYNC_VALUE_STATE::PROGRESS);
+    QVERIFY(states[1] == ASYNC_VALUE_STATE::VALUE);
+    QCOMPARE(spy.count(), 2);
+
+    value.emplaceValue("changed");
+    QCOMPARE(states.size(), 2);
+    QCOMPARE(spy.count(), 3);
+
+    // many waiters share striped locks
+    std::vector<std::unique_ptr<AsyncValueCompact<int>>> values;
+    for (int i = 0; i < 1000; ++i)
+    {
+        values.push_back(std::make_unique<AsyncValueCompact<int>>(AsyncInitByValue(), 0));
+        asyncValueRunThreadPool(*values.back(), [i](AsyncProgress&, AsyncValueCompact<int>& value) {
+            value.emplaceValue(i);
+        }, "", ASYNC_CAN_REQUEST_STOP::NO);
+    }
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        values[i]->wait();
+        QVERIFY(values[i]->accessValue([i](int value) {
+            QCOMPARE(value, i);
+        }));
+    }
+
+    // waiter destroys the value as soon as wait returns
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto value = std::make_unique<AsyncValueCompact<int>>(AsyncInitByValue(), 0);
+        auto valuePtr = value.get();
+        value->subscribe([valuePtr](ASYNC_VALUE_STATE state) {
+            // callbacks may wait the value they are called for
+            if (state != ASYNC_VALUE_STATE::PROGRESS)
+                valuePtr->wait();
+        });
+
+        asyncValueRunThreadPool(*value, [i](AsyncProgress&, AsyncValueCompact<int>& value) {
+            value.emplaceValue(i);
+        }, "", ASYNC_CAN_REQUEST_STOP::NO);
+
+        value->wait([i](int val) {
+            QCOMPARE(val, i);
+        }, AsyncNoOp());
+        value.reset();
+    }
+}
+
+class EvictableArray : public AsyncValueEvictable<QVector<int>>
+{
+public:
+    explicit EvictableArray(int size)
+        : AsyncValueEvictable<QVector<int>>(AsyncInitByError(), "Not calculated"),
+          m_size(size)
+    {
+    }
+
+    ~EvictableArray() override
+    {
+        stopEviction();
+    }
+
+    int runsCount() const { return m_runsCount.load(); }
+
+protected:
+    void deferImpl(RunFnType&& func) final
+    {
+        asyncValueRunThreadPool(*this, func, "", ASYNC_CAN_REQUEST_STOP::NO);
+    }
+
+    void runImpl(ProgressType&) final
+    {
+        m_runsCount.ref();
+        emplaceValue(m_size, m_size);
+    }
+
+private:
+    const int m_size;
+    QAtomicInt m_runsCount;
+};
+
+void TestAsyncValue::evictableValue()
+{
+    const auto arrayBytes = asyncValueByteSize(QVector<int>(100, 100));
+    AsyncEvictionManager manager(arrayBytes * 3);
+
+    std::vector<std::unique_ptr<EvictableArray>> arrays;
+    for (int i = 0; i < 5; ++i)
+    {
+        arrays.push_back(std::make_unique<EvictableArray>(100));
+        arrays.back()->setEvictionManager(&manager);
+        arrays.back()->run();
+        arrays.back()->wait();
+    }
+
+    // two least recently calculated arrays are evicted
+    QCOMPARE(manager.trackedCount(), 3);
+    QCOMPARE(manager.usedBytes(), arrayBytes * 3);
+    QCOMPARE(manager.evictedCount(), quint64(2));
+    QVERIFY(arrays[0]->isEvicted());
+    QVERIFY(arrays[1]->isEvicted());
+    QVERIFY(!arrays[2]->isEvicted());
+    QVERIFY(!arrays[3]->isEvicted());
+    QVERIFY(!arrays[4]->isEvicted());
+
+    // evicted array is recalculated by wait
+    arrays[0]->wait([](const QVector<int>& value) {
+        QCOMPARE(value.size(), 100);
+    }, [](const AsyncError&) {
+        QFAIL("Unexpected error");
+    });
+    QCOMPARE(arrays[0]->runsCount(), 2);
+    QVERIFY(!arrays[0]->isEvicted());
+    QCOMPARE(manager.evictedCount(), quint64(3));
+    QCOMPARE(manager.usedBytes(), arrayBytes * 3);
+
+    // value in error state is not tracked
+    arrays[4]->emplaceError("Failed");
+    QCOMPARE(manager.trackedCount(), 2);
+    QCOMPARE(manager.usedBytes(), arrayBytes * 2);
+
+    arrays.clear();
+    QCOMPARE(manager.trackedCount(), 0);
+}
+
+class PersistentTitle : public AsyncValuePersistent<QString>
+{
+public:
+    PersistentTitle(AsyncDiskCache* cache, QString key, quint32 version)
+        : AsyncValuePersistent<QString>(cache, key, version, AsyncInitByError(), "Not loaded")
+    {
+    }
+
+    int runsCount() const { return m_runsCount.load(); }
+
+protected:
+    void deferImpl(RunFnType&& func) final
+    {
+        asyncValueRunThreadPool(*this, func, "", ASYNC_CAN_REQUEST_STOP::NO);
+    }
+
+    void runImpl(ProgressType&) final
+    {
+        m_runsCount.ref();
+        emplaceValue(QString("Title of %1").arg(key()));
+    }
+
+private:
+    QAtomicInt m_runsCount;
+};
+
+void TestAsyncValue::persistentValue()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    {
+        AsyncDiskCache cache(directory.path());
+        PersistentTitle title(&cache, "item", 1);
+        QVERIFY(!title.loadOrRun());
+        title.wait();
+        QCOMPARE(title.runsCount(), 1);
+    }
+
+    AsyncDiskCache cache(directory.path());
+
+    // cached value is published immediately
+    PersistentTitle title(&cache, "item", 1);
+    QVERIFY(title.loadOrRun());
+    QCOMPARE(title.runsCount(), 0);
+    QVERIFY(title.accessValue([](const QString& value) {
+        QCOMPARE(value, QString("Title of item"));
+    }));
+
+    // stale version is recalculated
+    PersistentTitle newTitle(&cache, "item", 2);
+    QVERIFY(!newTitle.loadOrRun());
+    newTitle.wait();
+    QCOMPARE(newTitle.runsCount(), 1);
+
+    cache.flush();
+    QVERIFY(!title.load());
+    QVERIFY(newTitle.load());
+
+    cache.remove("item");
+    QVERIFY(!newTitle.load());
+}
+
+class LazySquare : public AsyncValueLazy<int>
+{
+public:
+    explicit LazySquare(int base)
+        : AsyncValueLazy<int>(AsyncInitByError(), "Not calculated"),
+          m_base(base)
+    {
+    }
+
+    int runsCount() const { return m_runsCount.load(); }
+
+protected:
+    void deferImpl(RunFnType&& func) final
+    {
+        asyncValueRunThreadPool(*this, func, "", ASYNC_CAN_REQUEST_STOP::NO);
+    }
+
+    void runImpl(ProgressType&) final
+    {
+        m_runsCount.ref();
+        emplaceValue(m_base * m_base);
+    }
+
+private:
+    const int m_base;
+    QAtomicInt m_runsCount;
+};
+
+void TestAsyncValue::lazyValue()
+{
+    std::vector<std::unique_ptr<LazySquare>> squares;
+    for (int i = 0; i < 100; ++i)
+        squares.push_back(std::make_unique<LazySquare>(i));
+
+    // nothing is calculated until used
+    for (const auto& square : squares)
+        QVERIFY(!square->isStarted());
+
+    // concurrent first waits run the value once
+    QThreadPool pool;
+    pool.setMaxThreadCount(8);
+    QAtomicInt wrongResults;
+    QVector<QFuture<void>> clients;
+    for (int i = 0; i < 8; ++i)
+    {
+        clients.append(QtConcurrent::run(&pool, [&squares, &wrongResults]() {
+            squares[7]->wait([&wrongResults](int value) {
+                if (value != 49)
+                    wrongResults.ref();
+            }, [&wrongResults](const AsyncError&) {
+                wrongResults.ref();
+            });
+        }));
+    }
+    for (auto& client : clients)
+        client.waitForFinished();
+
+    QCOMPARE(wrongResults.load(), 0);
+
+    QCOMPARE(squares[7]->runsCount(), 1);
+    QVERIFY(squares[7]->isStarted());
+
+    // access starts calculation too
+    QVERIFY(!squares[3]->accessError(AsyncNoOp()));
+    squares[3]->wait();
+    QCOMPARE(squares[3]->runsCount(), 1);
+
+    int runs = 0;
+    for (const auto& square : squares)
+        runs += square->runsCount();
+    QCOMPARE(runs, 2);
+}
+
+void TestAsyncValue::reclaimer()
+{
+    // records thread where the array is destroyed
+    struct Array
+    {
+        QVector<int> data = QVector<int>(10000, 1);
+        QThread** destroyedIn = nullptr;
+
+        ~Array()
+        {
+            if (destroyedIn)
+                *destroyedIn = QThread::currentThread();
+        }
+    };
+
+    QThread* destroyedIn = nullptr;
+    auto makeArray = [&destroyedIn]() {
+        auto array = std::make_unique<Array>();
+        array->destroyedIn = &destroyedIn;
+        return array;
+    };
+
+    AsyncReclaimer reclaimer(1024 * 1024, 0);
+    AsyncValue<Array> value(AsyncInitByError(), "");
+    QVERIFY(value.setReclaimer(&reclaimer));
+
+    // replaced array is destroyed in background
+    value.moveValue(makeArray());
+    value.emplaceValue();
+    reclaimer.flush();
+    QVERIFY(destroyedIn);
+    QVERIFY(destroyedIn != QThread::currentThread());
+    QCOMPARE(reclaimer.reclaimedCount(), quint64(2));
+    QCOMPARE(reclaimer.pendingBytes(), qint64(0));
+
+    // full backlog makes caller to destroy array
+    destroyedIn = nullptr;
+    reclaimer.setMaxPendingBytes(0);
+    value.moveValue(makeArray());
+    value.emplaceValue();
+    QCOMPARE(destroyedIn, QThread::currentThread());
+    QCOMPARE(reclaimer.overflowCount(), quint64(2));
+}
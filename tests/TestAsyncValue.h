@@ -13,12 +13,30 @@ public:
 private Q_SLOTS:
 
     void simple();
+    void version();
+    void staleWhileRefresh();
+    void notifyPolicy();
     void runInThread();
     void runInThreadPool();
+    void runInline();
     void catchDeadlock();
     void wait();
+    void manyWaiters();
+    void waitAndDestroy();
     void run();
+    void concurrentRun();
     void network();
+    void future();
+    void trace();
+    void lockStats();
+    void metrics();
+    void watchdog();
+    void memoryResource();
+    void compactValue();
+    void evictableValue();
+    void persistentValue();
+    void lazyValue();
+    void reclaimer();
 };
 
 #endif // TEST_ASYNC_VALUE_H
@@ -9,6 +9,8 @@ CONFIG   += c++14
 
 TEMPLATE = app
 
+include(../sanitizers.pri)
+
 HEADERS += \
     TestAsyncValue.h
 